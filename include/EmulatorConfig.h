@@ -9,7 +9,10 @@
 #define DEFAULT_FONT "IBMPlexSans-Light.ttf"
 #define DEFAULT_FONT_SIZE 20
 
-#define configFPS_LIMIT 1
+//the game paces its frames to configFPS_LIMIT_RATE itself, a second
+//limit in tumDrawUpdateScreen or vsync would only drop or delay them
+#define configFPS_LIMIT 0
 #define configFPS_LIMIT_RATE 50
+#define configVSYNC 0
 
 #endif //__EMULATOR_CONFIG_H__
@@ -0,0 +1,101 @@
+#ifndef __BROADPHASE__
+#define __BROADPHASE__
+
+#include <stdint.h>
+
+#define BROADPHASE_MIN_CELL_SHIFT 5
+#define BROADPHASE_MAX_CELLS_X 32
+#define BROADPHASE_MAX_CELLS_Y 32
+
+#define BROADPHASE_MAX_ENTITIES 128
+#define BROADPHASE_WORDS (BROADPHASE_MAX_ENTITIES / 64)
+
+/**
+ * @brief Bounding box of an entity registered in the grid
+ * and the range of cells it currently occupies.
+ *
+ */
+typedef struct broadphase_entity {
+    int16_t x;
+    int16_t y;
+    int16_t width;
+    int16_t height;
+
+    int8_t cx0, cy0, cx1, cy1;
+
+    uint8_t active;
+} broadphase_entity_t;
+
+/**
+ * @brief Uniform grid over the board. Each cell holds a bitset
+ * of the entities overlapping it so that a query only has to OR
+ * the few cells under the queried box. Cells are 32 pixels wide
+ * and grow by powers of two on boards too big for the grid.
+ *
+ */
+typedef struct broadphase {
+    uint64_t cell[BROADPHASE_MAX_CELLS_Y][BROADPHASE_MAX_CELLS_X][BROADPHASE_WORDS];
+    int cell_shift; /**< cells are 1 << cell_shift pixels wide */
+    int cells_x;
+    int cells_y;
+
+    broadphase_entity_t entity[BROADPHASE_MAX_ENTITIES];
+
+    unsigned long narrowphase_tests; /**< tests counted in the current tick */
+    unsigned long narrowphase_tests_last_tick; /**< tests counted in the last finished tick */
+    unsigned long narrowphase_tests_total; /**< tests counted in every finished tick */
+} broadphase_t;
+
+/**
+ * @brief Empties the grid and sizes its cells for the board.
+ *
+ * @param bp Grid to initiate.
+ * @param width Width of the board.
+ * @param height Height of the board.
+ */
+void vBroadphaseInit(broadphase_t *bp, int width, int height);
+
+/**
+ * @brief Inserts an entity or updates its bounding box. Cells are
+ * only touched if the range of cells covered by the entity changed.
+ *
+ * @param bp Grid holding the entity.
+ * @param id Entity id, smaller than BROADPHASE_MAX_ENTITIES
+ * @param x x coordinate of the box
+ * @param y y coordinate of the box
+ * @param width Width of the box.
+ * @param height Height of the box.
+ */
+void vBroadphaseUpdate(broadphase_t *bp, int id, int x, int y, int width, int height);
+
+/**
+ * @brief Removes an entity from every cell it occupies.
+ *
+ * @param bp Grid holding the entity.
+ * @param id Entity id.
+ */
+void vBroadphaseRemove(broadphase_t *bp, int id);
+
+/**
+ * @brief Collects every entity sharing a cell with the queried box.
+ *
+ * @param bp Grid to query.
+ * @param x0 Left of the box
+ * @param y0 Top of the box
+ * @param x1 Right of the box
+ * @param y1 Bottom of the box
+ * @param candidates Bitset of BROADPHASE_WORDS words filled with the entity ids found.
+ * @return 1 if any candidate was found and 0 otherwise.
+ */
+int vBroadphaseQuery(const broadphase_t *bp, int x0, int y0, int x1, int y1,
+                     uint64_t *candidates);
+
+/**
+ * @brief Stores the narrowphase test count of the tick that just
+ * finished, adds it to the total and restarts counting.
+ *
+ * @param bp Grid holding the counters.
+ */
+void vBroadphaseEndTick(broadphase_t *bp);
+
+#endif
@@ -0,0 +1,97 @@
+#ifndef __BULLETS__
+#define __BULLETS__
+
+#include <stdint.h>
+
+#define MAX_BULLETS 4096
+#define BULLET_POOL_WORDS (MAX_BULLETS / 64)
+#define BULLET_N_TYPES 3
+
+#define BULLET_INDEX_BITS 16
+#define BULLET_INDEX_MASK ((1u << BULLET_INDEX_BITS) - 1)
+#define BULLET_HANDLE_INVALID 0
+
+/**
+ * @brief Refers to a bullet slot. The upper bits hold the generation
+ * of the slot when it was handed out, so a handle to a bullet that has
+ * since been released (and maybe reused) can be told apart.
+ *
+ */
+typedef uint32_t bullet_handle_t;
+
+/**
+ * @brief Fixed capacity pool of bullets stored as a structure of arrays.
+ * Bullets are updated in place, live slots are tracked in the alive
+ * bitmask and released slots are chained in a free-list.
+ *
+ */
+typedef struct bullet_pool {
+    int16_t x[MAX_BULLETS];
+    int16_t y[MAX_BULLETS];
+    int16_t prev_y[MAX_BULLETS]; /**< y before the last move, bullets only move vertically */
+    uint8_t type[MAX_BULLETS];
+
+    uint16_t generation[MAX_BULLETS];
+    uint16_t next_free[MAX_BULLETS];
+
+    uint64_t alive[BULLET_POOL_WORDS];
+
+    uint16_t free_head;
+    uint16_t count;
+    uint16_t count_by_type[BULLET_N_TYPES];
+} bullet_pool_t;
+
+/**
+ * @brief Empties the pool and chains every slot in the free-list.
+ *
+ * @param pool Pool to initiate.
+ */
+void vBulletPoolInit(bullet_pool_t *pool);
+
+/**
+ * @brief Takes a slot from the free-list and fills it.
+ *
+ * @param pool Pool to take the slot from.
+ * @param x Initial x coordinate of bullet
+ * @param y Initial y coordinate of bullet
+ * @param type Type of bullet, smaller than BULLET_N_TYPES
+ * @return Handle to the new bullet, or BULLET_HANDLE_INVALID if the pool is full.
+ */
+bullet_handle_t vBulletPoolSpawn(bullet_pool_t *pool, int x, int y, int type);
+
+/**
+ * @brief Releases the bullet at slot index back to the free-list.
+ * Safe to call while iterating the pool.
+ *
+ * @param pool Pool holding the bullet.
+ * @param index Slot of a live bullet.
+ */
+void vBulletPoolRemoveAt(bullet_pool_t *pool, int index);
+
+/**
+ * @brief Resolves a handle to a slot index.
+ *
+ * @param pool Pool the handle was given by.
+ * @param handle Handle returned by vBulletPoolSpawn.
+ * @return Slot index, or -1 if the bullet no longer exists.
+ */
+int vBulletPoolResolve(const bullet_pool_t *pool, bullet_handle_t handle);
+
+/**
+ * @brief Finds the next live bullet.
+ *
+ * @param pool Pool to search.
+ * @param from First slot index to consider.
+ * @return Index of the first live bullet at or after from, or -1 if none.
+ */
+int vBulletPoolNext(const bullet_pool_t *pool, int from);
+
+/**
+ * @brief Iterates over the slot index of every live bullet.
+ *
+ */
+#define BULLET_POOL_FOREACH(pool, k) \
+    for ((k) = vBulletPoolNext((pool), 0); (k) >= 0; \
+         (k) = vBulletPoolNext((pool), (k) + 1))
+
+#endif
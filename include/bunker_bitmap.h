@@ -0,0 +1,89 @@
+#ifndef __BUNKER_BITMAP__
+#define __BUNKER_BITMAP__
+
+#include <stdint.h>
+
+#define BUNKER_CELL_SHIFT 1
+#define BUNKER_CELL_SIZE (1 << BUNKER_CELL_SHIFT)
+#define BUNKER_COLUMNS 22
+#define BUNKER_ROWS 16
+#define BUNKER_WIDTH (BUNKER_COLUMNS << BUNKER_CELL_SHIFT)
+#define BUNKER_HEIGHT (BUNKER_ROWS << BUNKER_CELL_SHIFT)
+
+/**
+ * @brief Occupancy of a bunker in cells of BUNKER_CELL_SIZE x
+ * BUNKER_CELL_SIZE pixels. Bit c of row[r] is set while the cell in
+ * column c of row r is still standing, so a whole row is tested or
+ * eroded with a single AND.
+ *
+ */
+typedef struct bunker_bitmap {
+    uint32_t row[BUNKER_ROWS];
+} bunker_bitmap_t;
+
+/**
+ * @brief Restores the intact bunker shape.
+ *
+ * @param bitmap Bitmap to initiate.
+ */
+void vBunkerBitmapInit(bunker_bitmap_t *bitmap);
+
+/**
+ * @brief Sweeps a vertical body of the given height over its last move,
+ * from prev_y to y, against the standing cells of its column. Coordinates
+ * are in pixels relative to the top left corner of the bunker.
+ *
+ * @param bitmap Bitmap to test.
+ * @param x x coordinate of the body
+ * @param prev_y Top of the body before the move
+ * @param y Top of the body after the move
+ * @param height Height of the body.
+ * @return Distance travelled before touching a standing cell, or -1 if none was touched.
+ */
+int vBunkerBitmapSweep(const bunker_bitmap_t *bitmap, int x, int prev_y,
+                       int y, int height);
+
+/**
+ * @brief Clears the cells under the blast mask centered on the given pixel.
+ *
+ * @param bitmap Bitmap to erode.
+ * @param x x coordinate of the impact, relative to the bunker
+ * @param y y coordinate of the impact, relative to the bunker
+ */
+void vBunkerBitmapErode(bunker_bitmap_t *bitmap, int x, int y);
+
+/**
+ * @brief Checks if any cell of the bunker is still standing.
+ *
+ * @param bitmap Bitmap to check.
+ * @return 1 if every cell was destroyed and 0 otherwise.
+ */
+int vBunkerBitmapEmpty(const bunker_bitmap_t *bitmap);
+
+/**
+ * @brief Finds the smallest band of rows covering every row
+ * that differs between two bitmaps.
+ *
+ * @param shown Bitmap currently shown.
+ * @param current Bitmap to be shown.
+ * @param first_row Filled with the first row of the band.
+ * @param n_rows Filled with the number of rows of the band.
+ * @return 1 if any row differs and 0 otherwise.
+ */
+int vBunkerBitmapDiff(const bunker_bitmap_t *shown, const bunker_bitmap_t *current,
+                      int *first_row, int *n_rows);
+
+/**
+ * @brief Expands a band of rows to ARGB pixels, BUNKER_WIDTH pixels
+ * per line and BUNKER_CELL_SIZE lines per row.
+ *
+ * @param bitmap Bitmap to expand.
+ * @param first_row First row of the band.
+ * @param n_rows Number of rows of the band.
+ * @param colour ARGB colour of standing cells, other cells are transparent
+ * @param pixels Buffer of at least n_rows * BUNKER_CELL_SIZE * BUNKER_WIDTH pixels.
+ */
+void vBunkerBitmapRasterise(const bunker_bitmap_t *bitmap, int first_row,
+                            int n_rows, uint32_t colour, uint32_t *pixels);
+
+#endif
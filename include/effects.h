@@ -0,0 +1,55 @@
+#ifndef __EFFECTS__
+#define __EFFECTS__
+
+#include <stdint.h>
+
+#define MAX_EFFECTS 1024
+
+/**
+ * @brief Fixed capacity pool of short lived images, such as
+ * explosions, stored as a structure of arrays. Live effects are
+ * kept packed at the front so they can be handed to the drawer in
+ * one go, an expired effect is replaced by the last one.
+ *
+ */
+typedef struct effect_pool {
+    int16_t x[MAX_EFFECTS]; /**< top left corner of the image */
+    int16_t y[MAX_EFFECTS];
+    uint8_t image[MAX_EFFECTS]; /**< id of the image, chosen by the owner */
+    uint32_t birth_tick[MAX_EFFECTS];
+    uint32_t lifetime_ticks[MAX_EFFECTS];
+
+    int count;
+} effect_pool_t;
+
+/**
+ * @brief Empties the pool.
+ *
+ * @param pool Pool to initiate.
+ */
+void vEffectPoolInit(effect_pool_t *pool);
+
+/**
+ * @brief Appends an effect to the pool.
+ *
+ * @param pool Pool to add the effect to.
+ * @param x x coordinate of the top left corner of the image
+ * @param y y coordinate of the top left corner of the image
+ * @param image Id of the image the effect is drawn with.
+ * @param birth_tick Game tick the effect appears on.
+ * @param lifetime_ticks Ticks the effect is shown for.
+ * @return 0 on success, -1 if the pool is full.
+ */
+int vEffectPoolSpawn(effect_pool_t *pool, int x, int y, int image,
+                     uint32_t birth_tick, uint32_t lifetime_ticks);
+
+/**
+ * @brief Removes every effect that has lived its lifetime by the given
+ * tick, moving the last effect into each freed slot.
+ *
+ * @param pool Pool to expire.
+ * @param tick Current game tick.
+ */
+void vEffectPoolExpire(effect_pool_t *pool, uint32_t tick);
+
+#endif
@@ -0,0 +1,108 @@
+#ifndef __FRAME_PACER__
+#define __FRAME_PACER__
+
+#include <stddef.h>
+#include <stdint.h>
+#include <stdio.h>
+
+#define FRAME_PACER_BUCKET_US 250
+#define FRAME_PACER_N_BUCKETS 400 /**< the last bucket holds everything slower */
+
+/**
+ * @brief Paces frames to a target rate and keeps a histogram of the
+ * time between two presented frames. Each frame has one period to be
+ * drawn and presented, ending at its deadline. A frame presented after
+ * its deadline is late, and the frames whose whole period went by
+ * are skipped, so the pacer catches up by drawing less instead of
+ * presenting less. Every function is given the current host time.
+ * Only to be used by the task presenting the screen.
+ *
+ */
+typedef struct frame_pacer {
+    uint64_t period_us;
+    uint64_t deadline_us; /**< when the current frame is to be presented */
+    uint64_t presented_us; /**< when the last frame was presented */
+
+    uint32_t bucket[FRAME_PACER_N_BUCKETS];
+    uint64_t n; /**< frames presented */
+    uint64_t sum_us;
+    uint64_t max_us;
+    uint64_t late; /**< frames presented after their deadline */
+    uint64_t skipped; /**< frames never drawn to catch up */
+    uint64_t missed; /**< frames drawn too late to be presented */
+} frame_pacer_t;
+
+/**
+ * @brief Starts pacing, the period of the first frame starting now.
+ *
+ * @param pacer Pacer to initiate.
+ * @param rate_hz Frames per second aimed at.
+ * @param now_us Current host time.
+ */
+void vFramePacerInit(frame_pacer_t *pacer, uint32_t rate_hz, uint64_t now_us);
+
+/**
+ * @brief Starts the current frame. If its deadline has passed, it
+ * and the frames of every other period that went by are skipped and
+ * the current frame is the one of the period that is running.
+ *
+ * @param pacer Pacer of the screen.
+ * @param now_us Current host time.
+ * @return Number of frames skipped, which are not to be drawn.
+ */
+uint32_t ulFramePacerBegin(frame_pacer_t *pacer, uint64_t now_us);
+
+/**
+ * @brief Gets how long to wait before the period of the current frame
+ * starts.
+ *
+ * @return Microseconds to wait, 0 once the period has started.
+ */
+uint64_t ulFramePacerUntilNext(const frame_pacer_t *pacer, uint64_t now_us);
+
+/**
+ * @brief Records that the current frame was presented and moves on
+ * to the next one.
+ *
+ * @param pacer Pacer of the screen.
+ * @param now_us When the frame was presented.
+ */
+void vFramePacerPresented(frame_pacer_t *pacer, uint64_t now_us);
+
+/**
+ * @brief Records that the current frame was not drawn in time to be
+ * presented and moves on to the next one.
+ *
+ */
+void vFramePacerMissed(frame_pacer_t *pacer);
+
+/**
+ * @brief Records that the screen was deliberately left as it was for
+ * the current frame and moves on to the next one. The frame is neither
+ * presented nor missed, and the next presented frame is not timed
+ * against the last one.
+ *
+ */
+void vFramePacerHeld(frame_pacer_t *pacer);
+
+/**
+ * @brief Formats one line with the frame count and the p50, p99 and
+ * max frame times, without a newline, so that tasks can hand it to
+ * prints.
+ *
+ * @param pacer Pacer of the screen.
+ * @param line Buffer the line is written to, cut short if too small.
+ * @param size Size of the buffer.
+ */
+void vFramePacerSummary(const frame_pacer_t *pacer, char *line, size_t size);
+
+/**
+ * @brief Writes the histogram of the frame times as CSV, one row per
+ * bucket, followed by the summary.
+ *
+ * @param pacer Pacer of the screen.
+ * @param fp File to write to.
+ */
+void vFramePacerDump(const frame_pacer_t *pacer, FILE *fp);
+
+#endif
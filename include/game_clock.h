@@ -0,0 +1,115 @@
+#ifndef __GAME_CLOCK__
+#define __GAME_CLOCK__
+
+#include <stdint.h>
+
+#define GAME_CLOCK_SCALE_ONE 1000 /**< scale of a clock running in real time */
+
+/**
+ * @brief Game time in microseconds, derived from a host clock. The
+ * game time only moves while the clock runs, at scale / 1000 times
+ * the speed of the host clock, and never goes backwards. Every
+ * function is given the current host time, so the clock can be driven
+ * by anything monotonic.
+ *
+ */
+typedef struct game_clock {
+    uint64_t game_us; /**< game time when the clock was last changed */
+    uint64_t host_us; /**< host time when the clock was last changed */
+    uint32_t scale;
+    int paused;
+} game_clock_t;
+
+/**
+ * @brief Deadline in game time, for anything that must happen after
+ * a while of play. Timers are only checked, never run by themselves,
+ * so pausing or speeding up the clock pauses or speeds up every timer.
+ *
+ */
+typedef struct game_timer {
+    uint64_t deadline_us;
+    uint64_t period_us; /**< 0 for a one shot timer */
+    int armed;
+} game_timer_t;
+
+/**
+ * @brief Gets the time of the host clock the game clocks of the
+ * game are driven by.
+ *
+ * @return Monotonic host time in microseconds.
+ */
+uint64_t vGameClockHostMicros(void);
+
+/**
+ * @brief Starts a clock at game time 0, running in real time.
+ *
+ * @param clock Clock to initiate.
+ * @param host_us Current host time.
+ */
+void vGameClockInit(game_clock_t *clock, uint64_t host_us);
+
+/**
+ * @brief Gets the game time.
+ *
+ * @param clock Clock to read.
+ * @param host_us Current host time, not before the last change.
+ * @return Game time in microseconds.
+ */
+uint64_t vGameClockNow(const game_clock_t *clock, uint64_t host_us);
+
+/**
+ * @brief Stops the game time until the clock is resumed.
+ *
+ * @param clock Clock to pause, pausing it twice does nothing.
+ * @param host_us Current host time.
+ */
+void vGameClockPause(game_clock_t *clock, uint64_t host_us);
+
+/**
+ * @brief Lets the game time run again from where it was paused.
+ *
+ * @param clock Clock to resume, resuming a running clock does nothing.
+ * @param host_us Current host time.
+ */
+void vGameClockResume(game_clock_t *clock, uint64_t host_us);
+
+/**
+ * @brief Changes how fast the game time runs from now on.
+ *
+ * @param clock Clock to change.
+ * @param host_us Current host time.
+ * @param scale Game time per host time, GAME_CLOCK_SCALE_ONE for real time.
+ */
+void vGameClockSetScale(game_clock_t *clock, uint64_t host_us, uint32_t scale);
+
+/**
+ * @brief Moves the game time forward at once, every timer whose
+ * deadline is skipped expires the next time it is checked.
+ *
+ * @param clock Clock to advance.
+ * @param us Game time to skip.
+ */
+void vGameClockAdvance(game_clock_t *clock, uint64_t us);
+
+/**
+ * @brief Arms a timer.
+ *
+ * @param timer Timer to arm.
+ * @param now_us Current game time.
+ * @param delay_us Game time before the timer first expires.
+ * @param period_us Game time between later expiries, 0 to only expire once.
+ */
+void vGameTimerStart(game_timer_t *timer, uint64_t now_us, uint64_t delay_us,
+                     uint64_t period_us);
+
+/**
+ * @brief Checks whether a timer expired and sets up its next expiry.
+ * A periodic timer that fell behind is caught up without drifting.
+ *
+ * @param timer Timer to check.
+ * @param now_us Current game time.
+ * @return Number of times the timer expired since last checked.
+ */
+unsigned int vGameTimerExpired(game_timer_t *timer, uint64_t now_us);
+
+#endif
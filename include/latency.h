@@ -0,0 +1,68 @@
+#ifndef __LATENCY__
+#define __LATENCY__
+
+#include <stdint.h>
+#include <stdio.h>
+
+#define LATENCY_BUCKET_US 1000
+#define LATENCY_N_BUCKETS 250 /**< the last bucket holds everything slower */
+#define LATENCY_MAX_PENDING 256
+
+/**
+ * @brief Counts of latencies in buckets of LATENCY_BUCKET_US.
+ *
+ */
+typedef struct latency_histogram {
+    uint32_t bucket[LATENCY_N_BUCKETS];
+    uint64_t n;
+    uint64_t sum_us;
+    uint64_t max_us;
+} latency_histogram_t;
+
+/**
+ * @brief Records presses taken by the game logic during a tick. Each
+ * press gets the next input sequence number. Only to be called by
+ * the game logic.
+ *
+ * @param event_us When each press happened, in host microseconds.
+ * @param n Number of presses.
+ * @param now_us When the tick consumed them.
+ */
+void vLatencyInputConsumed(const uint64_t *event_us, int n, uint64_t now_us);
+
+/**
+ * @brief Gets the sequence number of the last press consumed, to be
+ * published with the world the tick produced. Only to be called by
+ * the game logic.
+ *
+ */
+uint32_t ulLatencyInputSeq(void);
+
+/**
+ * @brief Notes that the frame being drawn shows every press up to
+ * the given sequence number. Only to be called by the game loop,
+ * before it hands the frame to the swap task.
+ *
+ * @param input_seq Input sequence number of the snapshot drawn.
+ */
+void vLatencyFrameDrawn(uint32_t input_seq);
+
+/**
+ * @brief Completes the latency of every press the presented frame
+ * is the first to show. Only to be called by the task presenting
+ * the screen.
+ *
+ * @param now_us When the frame was presented.
+ */
+void vLatencyPresented(uint64_t now_us);
+
+/**
+ * @brief Writes the histograms of the press to tick, tick to screen
+ * and press to screen latencies as CSV, one row per bucket, followed by
+ * a summary of each.
+ *
+ * @param fp File to write to.
+ */
+void vLatencyDump(FILE *fp);
+
+#endif
@@ -1,38 +1,14 @@
 #ifndef __OBJECTS__
 #define __OBJECTS__
 
-#define INITIAL_LIVES 3
+#include "world.h"
+#include "effects.h"
+#include "triple_buffer.h"
 
-#define ORIGINAL_TIMER 10000
-#define ORIGINAL_MONSTER_DELAY 65
+//as long as the old colisions lasted, 20 frames at 50 FPS
+#define EFFECT_LIFETIME_MS 400
 
-#define SPACESHIP_Y SCREEN_HEIGHT - 75
-#define CHANGE_IN_POSITION 1
-
-#define MAX_OBJECTS 10
-
-#define BULLET_HEIGHT 8
-#define SPACESHIP_BULLET 0
-#define MONSTER_BULLET 1
-#define MOTHERSHIP_BULLET 2
-
-#define N_ROWS 5
-#define N_COLUMNS 11
-
-#define MONSTER_SPACING_V 34
-#define MONSTER_SPACING_H 39
-
-#define SMALL_MONSTER 0
-#define MEDIUM_MONSTER 1
-#define LARGE_MONSTER 2
-
-#define N_BUNKERS 4
-
-#define MOTHERSHIP_Y 83
-
-#define LEFT_TO_RIGHT 1
-#define RIGHT_TO_LEFT -1
-#define STOP 0
+#define BUNKER_COLOUR (0xFF000000 | Green)
 
 /**
  * @brief Holds information regarding the player.
@@ -65,159 +41,60 @@ typedef struct saved_values {
 } saved_values_t;
 
 /**
- * @brief Hold spaceship information.
- * 
- */
-typedef struct spaceship {
-    image_handle_t image;
-
-    int x;
-    int y;
-
-    signed short width;
-    signed short height;
-
-    SemaphoreHandle_t lock;
-} spaceship_t;
-
-/**
- * @brief Holds bullet information.
- * 
- */
-typedef struct bullet {
-    int x;
-    int y;
-
-    signed short width;
-    signed short height;
-
-    unsigned int colour;
-
-    int type;
-} bullet_t;
-
-/**
- * @brief Holds colision information.
- * 
- */
-typedef struct colision {
-    image_handle_t image;
-
-    int x;
-    int y;
-
-    signed short width;
-    signed short height;
-
-    int frame_number;
-} colision_t;
-
-/**
- * @brief Holds monster information.
+ * @brief Images an effect can be drawn with.
  * 
  */
-typedef struct monster {
-    spritesheet_handle_t spritesheet;
-
-    int x;
-    int y;
-
-    signed short width;
-    signed short height;
-
-    int frametodraw;
-    int type;
-    int alive;
-} monster_t;
+enum effect_image {
+    EFFECT_IMPACT,    /**< a bullet that hit nothing */
+    EFFECT_EXPLOSION, /**< a monster, the spaceship or the mothership hit */
+    N_EFFECT_IMAGES,
+};
 
 /**
- * @brief Composes a grid of monster objects
- * to be handled safely with semaphore.
+ * @brief Copy of everything drawn during a match. The game logic
+ * fills one after each world step and publishes it whole, so
+ * readers never see a half moved formation.
  * 
  */
-typedef struct monster_grid {
-    monster_t monster[N_ROWS][N_COLUMNS];
-
-    callback_t callback; /**< monster callback */
-    void *args; /**< monster callback args */
-
-    SemaphoreHandle_t lock;
-} monster_grid_t;
+typedef struct world_snapshot {
+    unsigned long tick;
+    uint32_t input_seq; /**< last press the tick consumed, see latency.h */
 
-/**
- * @brief Holds mothership information.
- * 
- */
-typedef struct mothership {
-    image_handle_t image;
-
-    int x;
-    int y;
-
-    signed short width;
-    signed short height;
-
-    int alive;
-    int direction;
-
-    SemaphoreHandle_t lock;
-} mothership_t;
-
-/**
- * @brief Holds information for each piece of
- * each bunker.
- * 
- */
-typedef struct bunker_component {
-    image_handle_t image;
-
-    int x;
-    int y;
+    int score1;
+    int highscore;
+    int score2;
+    int n_lives;
+    int credits;
+    int n_players;
 
-    signed short width;
-    signed short height;
+    int spaceship_x;
+    int spaceship_y;
 
-    int damage;
-} bunker_component_t;
+    formation_t formation; /**< monsters are placed from their row when drawn */
 
-/**
- * @brief Each bunker is to be made out of
- * pieces to be handled separatly.
- * 
- */
-typedef struct bunker {
-    bunker_component_t component[2][3];
-} bunker_t;
+    int mothership_x;
+    int mothership_y;
+    int mothership_alive;
 
-/**
- * @brief Composes a grid of bunker objects
- * to be handled safely with semaphore.
- * 
- */
-typedef struct bunker_grid {
-    bunker_t bunker[N_BUNKERS];
-    SemaphoreHandle_t lock;
-} bunker_grid_t;
+    int bunker_x[N_BUNKERS];
+    int bunker_y[N_BUNKERS];
+    bunker_bitmap_t bunker[N_BUNKERS];
 
-extern TimerHandle_t xMothershipTimer;
+    int n_bullets; /**< bullets are packed, in pool order */
+    int16_t bullet_x[MAX_BULLETS];
+    int16_t bullet_y[MAX_BULLETS];
+    uint8_t bullet_type[MAX_BULLETS];
 
-extern QueueHandle_t BulletQueue;
-extern QueueHandle_t ColisionQueue;
-extern QueueHandle_t MonsterDelayQueue;
-extern QueueHandle_t TimerStartingQueue;
+    int n_effects; /**< effects are packed, in pool order */
+    int16_t effect_x[MAX_EFFECTS];
+    int16_t effect_y[MAX_EFFECTS];
+    uint8_t effect_image[MAX_EFFECTS];
+} world_snapshot_t;
 
 extern player_t my_player;
 
 extern saved_values_t saved;
 
-extern spaceship_t my_spaceship;
-
-extern monster_grid_t my_monsters;
-
-extern mothership_t my_mothership;
-
-extern bunker_grid_t my_bunkers;
-
 extern void checkDraw(unsigned char status, const char *msg);
 
 /**
@@ -233,30 +110,12 @@ void vInsertCoin(void);
 void vUseCoin(void);
 
 /**
- * @brief Updates player 2 score when mothership kills spaceship.
- * 
- */
-void vUpdateAIScore(void);
-
-/**
- * @brief Decrement number of lives.
- * 
- */
-void vPlayerGetHit(void);
-
-/**
- * @brief Updates player score using some randomness.
+ * @brief Copies the scores and lives of the match
+ * into the player object.
  * 
+ * @param world World the match is played in.
  */
-void vUpdatePlayerScoreRandom(void);
-
-/**
- * @brief Updates player 1 score based on monster killed
- * 
- * @param i row of the monster killed
- * @param j column of the monster killed.
- */
-void vUpdatePlayerScore(int i, int j);
+void vUpdatePlayerFromWorld(const world_t *world);
 
 /**
  * @brief Modifies number of player variable
@@ -296,317 +155,118 @@ void vInitSavedValues(void);
 /**
  * @brief Draws spaceship.
  * 
+ * @param world Snapshot to draw from.
  */
-void vDrawSpaceship(void);
-
-/**
- * @brief Prevents the spaceship from moving out of the screen.
- * 
- */
-void vFixSpaceshipOutofBounds(void);
-
-/**
- * @brief Moves spaceship right or left
- * 
- * @param direction If direction is 1 then moves right, if -1 then moves left
- */
-void vMoveSpaceship(int direction);
-
-/**
- * @brief Receives all bullets from queue, and checks 
- * if any of them are spaceship type
- * 
- * @param bullet_state This string should be "PASSIVE" 
- * if no bullet is active and "ATTACKING" otherwise
- * @return Returns the same information as the string 
- * mentioned above but in integer form.
- */
-int vSpaceshipBulletActive(char *bullet_state);
-
-/**
- * @brief Resets position of the spaceship.
- * 
- */
-void vResetSpaceship(void);
-
-/**
- * @brief Initiates spaceship object.
- * 
- * @param spaceship_image Image of spaceship.
- */
-void vInitSpaceship(image_handle_t spaceship_image);
+void vDrawSpaceship(const world_snapshot_t *world);
 
 /**
  * @brief Draws bullets.
  * 
+ * @param world Snapshot to draw from.
  */
-void vDrawBullets(void);
+void vDrawBullets(const world_snapshot_t *world);
 
 /**
- * @brief Receives every bullet in the queue, increments/decrements position 
- * and gives back to queue.
+ * @brief Draws every effect of the snapshot as one batch.
  * 
+ * @param world Snapshot to draw from.
  */
-void vUpdateBulletPosition(void);
+void vDrawEffects(const world_snapshot_t *world);
 
 /**
- * @brief Receives every bullet object in the queue, emptying it.
+ * @brief Shows an effect centred on the given point for
+ * EFFECT_LIFETIME_MS of game time. Only to be called by the
+ * game logic.
  * 
+ * @param image Image of the effect, an effect_image.
+ * @param x x coordinate of the centre of the effect
+ * @param y y coordinate of the centre of the effect
+ * @param tick World tick the effect appears on.
  */
-void vResetBulletQueue(void);
+void vSpawnEffect(int image, int x, int y, uint32_t tick);
 
 /**
- * @brief Creates bullet object and sends it to queue
+ * @brief Removes the effects that have been shown for their
+ * whole lifetime. Only to be called by the game logic.
  * 
- * @param initial_x Initial x coordinate of bullet
- * @param initial_y Initial y coordinate of bullet
- * @param type Bullets can be shot from spaceship, monsters or mothergunship
- * Each bullet from each enemy can have different types and we use this to determine
- * if the bullet moves up or down, for example.
+ * @param tick Current world tick.
  */
-void vShootBullet(int initial_x, int initial_y, int type);
+void vExpireEffects(uint32_t tick);
 
 /**
- * @brief Draws colision.
+ * @brief Removes every effect. Only to be called by the game logic.
  * 
- * @param my_colision 
  */
-void vDrawColision(colision_t my_colision);
-
-/**
- * @brief Receives colision object from queue, draws the image,
- *  increments count and returns colision to queue.
- * If the colision has been drawn for more than N_TICKS 
- *  does not return it to queue, deleting it 
- * 
- */
-void vDrawColisions(void);
-
-/**
- * @brief Receives every colision object in the queue, emptying it.
- * 
- */
-void vResetColisionQueue(void);
-
-/**
- * @brief Creates a Colision object and sends it to queue by copy
- * 
- * @param bullet_x x coordinate of the bullet that created the colision
- * @param bullet_y y coordinate of the bullet that created the colision
- * @param image_buffer Image of colision to be drawn.
- */
-void createColision(int bullet_x, int bullet_y, image_handle_t image_buffer);
+void vResetEffects(void);
 
 /**
  * @brief Draws all alive monsters.
  * 
+ * @param world Snapshot to draw from.
  */
-void vDrawMonsters(void);
+void vDrawMonsters(const world_snapshot_t *world);
 
 /**
  * @brief Plays monster moving sound
  * 
- * @param args Arguments of callback function.
- */
-void vPlayMonsterSound(void *args);
-
-/**
- * @brief Callback of monster object.
- * 
- */
-void vMonsterCallback(void);
-
-/**
- * @brief Kills indexed monster
- * 
- * @param i row of the monster
- * @param j column of the monster.
- */
-void vKillMonster(int i, int j);
-
-/**
- * @brief For a certain row, computes the leftmost alive monster
- * 
- * @param i row to compute left most alive monster
- * @return Returns the index of the leftmost alive monster, or -1 of all are dead.
- */
-int vComputeRightmostMonster(int i);
-
-/**
- * @brief For a certain row, computes the rightmost alive monster
- * 
- * @param i row to compute rightmost alive monster
- * @return Returns the index of the rightmost alive monster, or -1 of all are dead.
- */
-int vComputeLeftmostMonster(int i);
-
-/**
- * @brief Moves all the alive monster down a step
- * 
- */
-void vMonsterMoveCloser(void);
-
-/**
- * @brief Checks the direction that the monsters should be updated.
- * If any monster touches the walls reverts direction
- * 
- * 
- * @param direction Determines if the monster should be moved right or left.
- */
-void vUpdateMonsterDirection(int *direction);
-
-/**
- * @brief Moves selected monster left or right if alive
- * 
- * @param row row of the monster to move
- * @param column column of the monster to move
- * @param direction Determines if the monster should be moved right or left.
- * @return 1 if the monster was moved successfully and 0 otherwise
- */
-int vMoveMonster(int row, int column, int direction);
-
-/**
- * @brief Resets position of all the monsters
- * and sets alive variable to 1.
- * 
- */
-void vResetMonsters(void);
-
-/**
- * @brief Initiates monster grid
- * 
- * @param monster_image Image of each monster and is used to 
- * compute monster width and height.
- * @param monster_spritesheet Spritesheet of monster frames 
- * to be drawn.
  */
-void vInitMonsters(image_handle_t *monster_image, spritesheet_handle_t *monster_spritesheet);
-
-/**
- * @brief Overwrites the queue with the original monster delay
- * plus a certain offset that is saved on "saved" object.
- * 
- */
-void vResetMonsterDelay(void);
-
-/**
- * @brief Decrements current monster delay 
- * overwrites queue.
- * 
- */
-void vDecreaseMonsterDelay(void);
-
-/**
- * @brief Overwrites a defined value to the
- * monster delay queue.
- * 
- */
-void vInitMonsterDelay(void);
+void vPlayMonsterSound(void);
 
 /**
  * @brief Draws mothership.
  * 
+ * @param world Snapshot to draw from.
  */
-void vDrawMothership(void);
+void vDrawMothership(const world_snapshot_t *world);
 
 /**
- * @brief Sets initial position of mothership
- * and sets alive variable to 1.
+ * @brief Uploads the rows of each bunker that changed since
+ * they were last shown and draws the bunkers.
  * 
+ * @param world Snapshot to draw from.
  */
-void vSetUpMothershipPVP(void);
+void vDrawBunkers(const world_snapshot_t *world);
 
 /**
- * @brief Revives mothergunship, reverses direction and updates timer.
- * 
- */
-void vResetMothership(void);
-
-/**
- * @brief This function gets called when the mothership timer expires.
- * 
- * @param xMothershipTimer 
- */
-void vMothershipTimerCallback(TimerHandle_t xMothershipTimer);
-
-/**
- * @brief Set .alive variable to 0 safely.
- * 
- */
-void vKillMothership(void);
-
-/**
- * @brief Set .alive variable to 1 safely.
- * 
- */
-void vReviveMothership(void);
-
-/**
- * @brief Checks if mothership is out of left of screen.
- * 
- * @return Return 1 if out of left of screen, and 0 otherwise.
- */
-int vIsMothershipInBoundsLeft(void);
-
-/**
- * @brief Checks if mothership is out of right of screen.
- * 
- * @return Return 1 if out of right of screen, and 0 otherwise.
- */
-int vIsMothershipInBoundsRight(void);
-
-/**
- * @brief Increments or decrements mothership position depeding
- * on direction variable. Does not change position if out of bounds
- * or if mothership is dead.
- * 
- */
-void vUpdateMothershipPositionPVP(void);
-
-/**
- * @brief Increments or decrements mothership position depeding
- * on direction variable. Does not change position if mothership
- * is dead. If mothership goes out of bounds resets the mothership
- * and the associated timer.
- * 
- */
-void vUpdateMothershipPosition(void);
-
-/**
- * @brief Initiates mothership object.
+ * @brief Keeps the images every object is drawn with, creates
+ * the image each bunker is drawn from and takes the size of
+ * each object from its image.
  * 
+ * @param spaceship_image Image of spaceship.
+ * @param monster_image Image of each monster type, holding both frames.
+ * @param monster_spritesheet Spritesheet of monster frames to be drawn.
  * @param mothership_image Image of mothership.
+ * @param effect_image Image of each effect, indexed by effect_image.
+ * @param config Returns the sizes of the objects.
  */
-void vInitMothership(image_handle_t mothership_image);
-
-/**
- * @brief Draws not too damaged bunker components.
- * 
- */
-void vDrawBunkers(void);
+void vInitSprites(image_handle_t spaceship_image, image_handle_t *monster_image,
+                  spritesheet_handle_t *monster_spritesheet,
+                  image_handle_t mothership_image, image_handle_t *effect_image,
+                  world_config_t *config);
 
 /**
- * @brief Increments damage variable of bunker piece
+ * @brief Prepares the snapshot buffers, nothing is published yet.
  * 
- * @param a Number of bunker that got hit
- * @param i Row of bunker piece that got hit
- * @param j Column of bunker piece that got hit.
  */
-void vBunkerGetHit(int a, int i, int j);
+void vInitWorldSnapshots(void);
 
 /**
- * @brief Resets damage on all bunkers and bunker pieces.
+ * @brief Copies the world, plus the highscore and credits of
+ * the player, and publishes it as the latest snapshot. Only to
+ * be called by the game logic.
  * 
+ * @param world World to copy.
+ * @return The published snapshot, valid until the next publish.
  */
-void vResetBunkers(void);
+const world_snapshot_t *vPublishWorldSnapshot(const world_t *world);
 
 /**
- * @brief Initiates bunker object.
+ * @brief Takes the latest published snapshot. Only to be
+ * called by the game drawer.
  * 
- * @param bunker_image Array containing the images of each
- * part of each bunker.
+ * @return Snapshot that stays untouched until the next acquire.
  */
-void vInitBunkers(image_handle_t *bunker_image);
+const world_snapshot_t *vAcquireWorldSnapshot(void);
 
 /**
  * @brief Deletes all semaphores created.
@@ -21,8 +21,9 @@ void vSendBulletState(char *bullet_state_tosend);
  * @brief Sends string containing player and opponent
  * location difference signed change to opponent.
  * 
+ * @param world Published snapshot the positions are taken from.
  */
-void vSendSpaceshipMothershipDiff(void);
+void vSendSpaceshipMothershipDiff(const world_snapshot_t *world);
 
 /**
  * @brief Sends string containing difficulty change to opponent.
@@ -42,6 +43,13 @@ void vSendDifficultyChange(char *tosend);
  */
 void vReceiveCallback(size_t receive_size, char *buffer, void *args);
 
+/**
+ * @brief Gives the last direction the opponent ordered the mothership to move.
+ * 
+ * @return LEFT_TO_RIGHT, RIGHT_TO_LEFT or STOP
+ */
+int vGetOpponentDirection(void);
+
 /**
  * @brief Opens socket to receive information from opponent.
  * 
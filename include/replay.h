@@ -0,0 +1,151 @@
+#ifndef __REPLAY__
+#define __REPLAY__
+
+#include <stdint.h>
+#include <stdio.h>
+
+#include "world.h"
+
+#define REPLAY_MAGIC 0x594C5052 /**< "RPLY" read as a little endian word */
+#define REPLAY_VERSION 2
+#define REPLAY_MAX_BOARD_SIZE 0x4000 /**< larger boards are taken for damage */
+
+/**
+ * @brief Records of a replay. Each one starts with a varint holding
+ * its type in the low REPLAY_TYPE_BITS bits and its first value in
+ * the others, so that a step of a usual length fits in one byte.
+ *
+ */
+enum replay_type {
+    REPLAY_STEP, /**< one world step, value is its length in ms */
+    REPLAY_REPEAT, /**< value more steps as long as the last one */
+    REPLAY_INPUT, /**< value is the packed input held from then on */
+    REPLAY_MATCH, /**< a match starts, see world_start_match */
+    REPLAY_BOARD, /**< the board is set up again, see world_reset_board */
+    REPLAY_PAUSE, /**< the game was paused */
+    REPLAY_COIN, /**< a coin was inserted */
+    N_REPLAY_TYPES
+};
+
+#define REPLAY_TYPE_BITS 3
+
+/**
+ * @brief Everything the world is set up with, written at the start
+ * of the replay.
+ *
+ */
+typedef struct replay_header {
+    uint32_t seed;
+    world_config_t config;
+    wave_t wave;
+} replay_header_t;
+
+/**
+ * @brief One record read back from a replay, REPLAY_REPEAT records
+ * come back as steps with n_steps set.
+ *
+ */
+typedef struct replay_event {
+    int type;
+
+    //REPLAY_STEP
+    uint32_t dt_ms;
+    uint32_t n_steps;
+    input_t input; /**< held during the steps */
+
+    //REPLAY_MATCH and REPLAY_BOARD
+    int n_players;
+    int n_lives;
+    int score;
+    int monster_delay_offset_ms;
+    wave_t wave;
+} replay_event_t;
+
+/**
+ * @brief A replay being written or read. Runs of equal steps are
+ * held back and written as a single record once the run ends.
+ *
+ */
+typedef struct replay {
+    FILE *fp;
+
+    uint32_t input; /**< packed input last written or read */
+    uint32_t dt_ms; /**< length of the steps of the run */
+    uint32_t n_steps; /**< steps of the run not written yet */
+} replay_t;
+
+/**
+ * @brief Creates a replay file and writes how the world is set up.
+ *
+ * @param replay Replay to write.
+ * @param path Path of the file, which is replaced.
+ * @param header Seed, config and first wave given to world_init.
+ * @return 0 on success, -1 if the file could not be written.
+ */
+int vReplayCreate(replay_t *replay, const char *path,
+                  const replay_header_t *header);
+
+/**
+ * @brief Records one call to world_step.
+ *
+ * @param replay Replay being written.
+ * @param input Input given to the step.
+ * @param dt_ms Length of the step.
+ */
+void vReplayStep(replay_t *replay, const input_t *input, uint32_t dt_ms);
+
+/**
+ * @brief Records one call to world_start_match, the wave is stored
+ * in the replay.
+ *
+ */
+void vReplayStartMatch(replay_t *replay, int n_players, int n_lives,
+                       int score, const wave_t *wave,
+                       int monster_delay_offset_ms);
+
+/**
+ * @brief Records one call to world_reset_board, the wave is stored
+ * in the replay.
+ *
+ */
+void vReplayResetBoard(replay_t *replay, const wave_t *wave,
+                       int monster_delay_offset_ms);
+
+/**
+ * @brief Records something that happened between two steps without
+ * changing the world, REPLAY_PAUSE or REPLAY_COIN.
+ *
+ */
+void vReplayMark(replay_t *replay, int type);
+
+/**
+ * @brief Writes what is held back and closes the replay, whether it
+ * was being written or read.
+ *
+ * @param replay Replay to close.
+ */
+void vReplayClose(replay_t *replay);
+
+/**
+ * @brief Opens a replay and reads how the world was set up.
+ *
+ * @param replay Replay to read.
+ * @param path Path of the file.
+ * @param header Filled with the seed, config and first wave.
+ * @return 0 on success, -1 if the file could not be read, is not a
+ * replay or its config has a size out of range.
+ */
+int vReplayOpen(replay_t *replay, const char *path, replay_header_t *header);
+
+/**
+ * @brief Reads the next record of a replay.
+ *
+ * @param replay Replay being read.
+ * @param event Filled with the record.
+ * @return 1 if a record was read, 0 at the end of the replay and
+ * -1 if the replay is damaged or holds a value the world cannot be
+ * set up with.
+ */
+int vReplayNext(replay_t *replay, replay_event_t *event);
+
+#endif
@@ -0,0 +1,46 @@
+#ifndef __RNG__
+#define __RNG__
+
+#include <stdint.h>
+
+/**
+ * @brief State of a PCG32 generator. Each part of the world that
+ * draws numbers gets its own, so that drawing more in one part does
+ * not change what another part gets. The state is a plain value and
+ * can be copied along with the world to be replayed from there.
+ *
+ */
+typedef struct rng {
+    uint64_t state;
+    uint64_t inc; /**< picks the stream, always odd */
+} rng_t;
+
+/**
+ * @brief Seeds a generator. Generators seeded alike but on different
+ * streams give unrelated sequences.
+ *
+ * @param rng Generator to seed.
+ * @param seed Starting point of the sequence.
+ * @param stream Sequence to draw from.
+ */
+void vRngSeed(rng_t *rng, uint64_t seed, uint64_t stream);
+
+/**
+ * @brief Draws the next number of a generator.
+ *
+ * @param rng Generator to draw from.
+ * @return Number spread evenly over the whole 32 bits.
+ */
+uint32_t uRngNext(rng_t *rng);
+
+/**
+ * @brief Draws a number below a bound, without the bias of taking
+ * the remainder.
+ *
+ * @param rng Generator to draw from.
+ * @param bound Number of values that can be drawn, more than 0.
+ * @return Number between 0 and bound - 1.
+ */
+uint32_t uRngBelow(rng_t *rng, uint32_t bound);
+
+#endif
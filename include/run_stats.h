@@ -0,0 +1,50 @@
+#ifndef __RUN_STATS__
+#define __RUN_STATS__
+
+#include <signal.h>
+#include <stdio.h>
+
+#define RUN_STATS_MAX_TASKS 16
+#define RUN_STATS_SIGNAL SIGQUIT /**< asks for a sample right away */
+
+/**
+ * @brief Installs the handler of RUN_STATS_SIGNAL and takes the
+ * sample the first one is measured from. Only to be called by the
+ * task writing the samples.
+ *
+ */
+void vRunStatsInit(void);
+
+/**
+ * @brief Tells whether RUN_STATS_SIGNAL was received since the last
+ * call.
+ *
+ * @return 1 if a sample was asked for, 0 otherwise.
+ */
+int xRunStatsRequested(void);
+
+/**
+ * @brief Writes the CSV header of the samples.
+ *
+ * @param fp File to write to.
+ */
+void vRunStatsHeader(FILE *fp);
+
+/**
+ * @brief Writes one row per task with its share of the run time, the
+ * times it was switched to and the times the tick switched away from
+ * it since the last sample.
+ *
+ * @param fp File to write to.
+ * @param state Name of the state the game was in during the sample.
+ */
+void vRunStatsSample(FILE *fp, const char *state);
+
+/**
+ * @brief Prints the run time of every task since the scheduler
+ * started, as formatted by vTaskGetRunTimeStats.
+ *
+ */
+void vRunStatsPrint(void);
+
+#endif
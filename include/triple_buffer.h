@@ -0,0 +1,54 @@
+#ifndef __TRIPLE_BUFFER__
+#define __TRIPLE_BUFFER__
+
+#define TRIPLE_BUFFER_INDEX_MASK 0x3
+#define TRIPLE_BUFFER_FRESH 0x4
+
+/**
+ * @brief Hands three buffers between one writer and one reader
+ * without locks. The writer always owns the back buffer and the
+ * reader the front one, the third one sits in the middle and is
+ * swapped atomically, so neither side ever sees a buffer that is
+ * being written.
+ *
+ */
+typedef struct triple_buffer {
+    int back; /**< index of the buffer being written */
+    int front; /**< index of the buffer being read */
+    int middle; /**< index of the spare buffer, TRIPLE_BUFFER_FRESH set if it was published since the last acquire */
+} triple_buffer_t;
+
+/**
+ * @brief Assigns the three buffers, none of them published.
+ *
+ * @param tb Triple buffer to initiate.
+ */
+void vTripleBufferInit(triple_buffer_t *tb);
+
+/**
+ * @brief Gets the buffer the writer is allowed to fill.
+ *
+ * @param tb Triple buffer.
+ * @return Index of the back buffer.
+ */
+int vTripleBufferBack(const triple_buffer_t *tb);
+
+/**
+ * @brief Publishes the back buffer and takes the spare one as
+ * the new back buffer. Only to be called by the writer.
+ *
+ * @param tb Triple buffer.
+ * @return Index of the buffer that was just published.
+ */
+int vTripleBufferPublish(triple_buffer_t *tb);
+
+/**
+ * @brief Takes the most recently published buffer if there is one newer
+ * than the front buffer. Only to be called by the reader.
+ *
+ * @param tb Triple buffer.
+ * @return Index of the front buffer.
+ */
+int vTripleBufferAcquire(triple_buffer_t *tb);
+
+#endif
@@ -0,0 +1,76 @@
+#ifndef __WAVE_PACK__
+#define __WAVE_PACK__
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include "world.h"
+
+#define WAVE_PACK_MAGIC 0x4B505657 /**< "WVPK" read as a little endian word */
+#define WAVE_PACK_VERSION 1
+
+/**
+ * @brief Start of a wave pack file, the n_waves wave_t records
+ * follow right after it.
+ *
+ */
+typedef struct wave_pack_header {
+    uint32_t magic;
+    uint16_t version;
+    uint16_t wave_size; /**< WAVE_SIZE of the writer */
+    uint32_t n_waves;
+    uint32_t reserved;
+} wave_pack_header_t;
+
+_Static_assert(sizeof(wave_pack_header_t) == 16, "wave_pack_header_t is stored as is");
+
+/**
+ * @brief A wave pack mapped read only. The waves are used where
+ * they lie in the mapping, nothing is parsed nor copied.
+ *
+ */
+typedef struct wave_pack {
+    const void *map;
+    size_t size;
+
+    const wave_t *waves;
+    unsigned int n_waves;
+} wave_pack_t;
+
+/**
+ * @brief Maps a wave pack and checks that every wave in it can be
+ * played, so that the waves can be trusted from then on.
+ *
+ * @param pack Pack to open.
+ * @param path Path of the wave pack file.
+ * @return 0 on success, -1 if the file could not be mapped or is not
+ * a valid wave pack, in which case the pack is left empty.
+ */
+int vWavePackOpen(wave_pack_t *pack, const char *path);
+
+/**
+ * @brief Unmaps a wave pack, waves taken from it must no longer be used.
+ *
+ * @param pack Pack to close.
+ */
+void vWavePackClose(wave_pack_t *pack);
+
+/**
+ * @brief Gets a wave of the pack, starting over from the first wave
+ * once the last one was played.
+ *
+ * @param pack Pack holding the wave.
+ * @param index Number of waves played before this one.
+ * @return The wave, or NULL if the pack is empty.
+ */
+const wave_t *vWavePackWave(const wave_pack_t *pack, unsigned int index);
+
+/**
+ * @brief Checks that a wave can be played.
+ *
+ * @param wave Wave to check.
+ * @return 1 if it can and 0 otherwise.
+ */
+int vWaveIsValid(const wave_t *wave);
+
+#endif
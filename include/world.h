@@ -0,0 +1,398 @@
+#ifndef __WORLD__
+#define __WORLD__
+
+#include <stdint.h>
+
+#include "EmulatorConfig.h"
+
+#include "bullets.h"
+#include "broadphase.h"
+#include "bunker_bitmap.h"
+#include "rng.h"
+
+#define WORLD_TICK_MS 8
+
+#define INITIAL_LIVES 3
+
+#define ORIGINAL_TIMER 10000
+#define ORIGINAL_MONSTER_DELAY 65
+//added to the march delay by the cheat, never more or the delay
+//would not stay positive over a game
+#define MAX_MONSTER_DELAY_OFFSET 20
+#define MONSTER_SHOOT_PERIOD 2500
+
+//vertical positions near the bottom follow the height of the board
+#define SPACESHIP_Y(board_height) ((board_height) - 75)
+#define CHANGE_IN_POSITION 1
+
+#define BULLET_WIDTH 1
+#define BULLET_HEIGHT 8
+#define SPACESHIP_BULLET 0
+#define MONSTER_BULLET 1
+#define MOTHERSHIP_BULLET 2
+
+//size of the original wave
+#define N_ROWS 5
+#define N_COLUMNS 11
+
+#define FORMATION_MAX_ROWS 128
+#define FORMATION_MAX_COLUMNS 128
+#define FORMATION_WORDS(n) (((n) + 63) / 64)
+#define FORMATION_ROW_WORDS FORMATION_WORDS(FORMATION_MAX_COLUMNS)
+#define FORMATION_COLUMN_WORDS FORMATION_WORDS(FORMATION_MAX_ROWS)
+
+#define MONSTER_SPACING_V 34
+#define MONSTER_SPACING_H 39
+
+#define SMALL_MONSTER 0
+#define MEDIUM_MONSTER 1
+#define LARGE_MONSTER 2
+#define N_MONSTER_TYPES 3
+
+#define N_BUNKERS 4
+#define BUNKER_Y(board_height) ((board_height) - 137)
+
+#define MOTHERSHIP_Y 83
+
+#define MONSTER_ORIGIN_X 15
+#define MONSTER_ORIGIN_Y(board_height) ((board_height) / 4)
+
+#define GREEN_LINE_Y(board_height) ((board_height) - 38)
+#define TOP_LINE_Y 75
+
+#define GRID_SPACESHIP 0
+#define GRID_MOTHERSHIP (GRID_SPACESHIP + 1)
+#define GRID_BUNKER(a) (GRID_MOTHERSHIP + 1 + (a))
+
+#define LEFT_TO_RIGHT 1
+#define RIGHT_TO_LEFT -1
+#define STOP 0
+
+//a bullet ends at most once per tick, so the events of a tick always fit
+#define MAX_GAME_EVENTS MAX_BULLETS
+#define MAX_SHOWN_EVENTS 256
+
+#define EVENT_MONSTER_KILLED 0
+#define EVENT_PLAYER_HIT 1
+#define EVENT_BUNKER_HIT 2
+#define EVENT_MOTHERSHIP_HIT 3
+#define EVENT_BULLET_SPENT 4
+
+#define WORLD_CUE_SHOOT (1u << 0)
+#define WORLD_CUE_MARCH (1u << 1)
+#define WORLD_CUE_MOTHERSHIP (1u << 2)
+#define WORLD_CUE_MONSTER_KILLED (1u << 3)
+#define WORLD_CUE_EXPLOSION (1u << 4)
+
+#define WORLD_PLAYING 0
+#define WORLD_WAVE_CLEARED 1
+#define WORLD_PLAYER_DEAD 2
+
+/**
+ * @brief Outcome of a bullet hit found while
+ * checking colisions, applied later in one batch.
+ *
+ */
+typedef struct game_event {
+    int type;
+
+    int x; /**< where the colision is shown, or the impact on a bunker */
+    int y;
+
+    int i; /**< monster row, or bunker number */
+    int j; /**< monster column */
+
+    int bullet_type;
+} game_event_t;
+
+/**
+ * @brief Events found during one world tick. Hits already
+ * recorded in the current tick are remembered so that later
+ * bullets of the same tick pass through objects that are
+ * about to die.
+ *
+ */
+typedef struct game_events {
+    game_event_t event[MAX_GAME_EVENTS];
+    int count;
+
+    uint64_t monsters_killed[FORMATION_MAX_ROWS][FORMATION_ROW_WORDS]; /**< bit j of row i is set if monster [i][j] was killed */
+    int spaceship_hit;
+    int mothership_hit;
+} game_events_t;
+
+/**
+ * @brief What the player asked for during a step.
+ *
+ */
+typedef struct input {
+    int move; /**< LEFT_TO_RIGHT, RIGHT_TO_LEFT or STOP */
+    int shoot;
+    int mothership_direction; /**< ordered by the opponent, only used with 2 players */
+} input_t;
+
+/**
+ * @brief Sizes of the board and the objects. The object sizes are
+ * taken from their images by the game or made up when running
+ * without graphics.
+ *
+ */
+typedef struct world_config {
+    int board_width;
+    int board_height;
+
+    int spaceship_width;
+    int spaceship_height;
+    int monster_width[N_MONSTER_TYPES];
+    int monster_height[N_MONSTER_TYPES];
+    int mothership_width;
+    int mothership_height;
+} world_config_t;
+
+#define WAVE_NO_BUNKER 0xFFFF
+
+/**
+ * @brief Everything that sets one wave apart from another. Waves
+ * are stored in this exact layout in wave packs and used straight
+ * from the mapped file, so every field has a fixed size and the
+ * record is padded to WAVE_SIZE bytes.
+ *
+ */
+typedef struct wave {
+    uint16_t formation_rows; /**< 1 to FORMATION_MAX_ROWS */
+    uint16_t formation_columns; /**< 1 to FORMATION_MAX_COLUMNS */
+    uint16_t monster_delay_ms; /**< time between two monsters of the march */
+    uint16_t n_shooters; /**< columns firing at once */
+    uint32_t fire_period_ms;
+    uint32_t mothership_period_ms; /**< time between two flybys */
+    uint8_t aimed; /**< 1 if the column above the spaceship fires first */
+    uint8_t reserved;
+    uint16_t bunker_x_permille[N_BUNKERS]; /**< left edge of each bunker past the margin, in thousandths of the board, or WAVE_NO_BUNKER */
+    uint8_t row_type[FORMATION_MAX_ROWS]; /**< monster type of each row, from the top */
+    uint8_t padding[6];
+} wave_t;
+
+#define WAVE_SIZE 160
+_Static_assert(sizeof(wave_t) == WAVE_SIZE, "wave_t is stored as is in wave packs");
+
+#define BUNKER_MARGIN_X 30
+
+/**
+ * @brief Monsters sit on a lattice so each row keeps the
+ * position of its column 0 and how far through its current
+ * step it is, which lets a position be mapped back to a monster
+ * and the position and frame of any monster be derived. A step
+ * of the march only ever changes the numbers of one row, however
+ * many monsters the formation holds.
+ * Which monsters are alive is kept as bitsets per row and per
+ * column so it can be queried without scanning. The march is a
+ * cursor over the lattice that reaches the next alive monster
+ * every monster_delay_ms.
+ * The lattice is sized when the board is reset, only the first
+ * n_rows rows and n_columns columns of the arrays are used.
+ *
+ */
+typedef struct formation {
+    int n_rows;
+    int n_columns;
+
+    int type[FORMATION_MAX_ROWS];
+    int width[FORMATION_MAX_ROWS];
+    int height[FORMATION_MAX_ROWS];
+
+    uint64_t row_alive[FORMATION_MAX_ROWS][FORMATION_ROW_WORDS]; /**< bit j is set if monster (i, j) is alive */
+    uint64_t column_alive[FORMATION_MAX_COLUMNS][FORMATION_COLUMN_WORDS]; /**< bit i is set if monster (i, j) is alive */
+    uint64_t rows_alive[FORMATION_COLUMN_WORDS]; /**< bit i is set if row i has any monster alive */
+    int row_count[FORMATION_MAX_ROWS]; /**< monsters alive in the row */
+    int column_bottom[FORMATION_MAX_COLUMNS]; /**< bottom-most row alive in the column, -1 if none */
+    int live_columns[FORMATION_MAX_COLUMNS]; /**< columns with a monster alive, in no particular order */
+    int live_column_index[FORMATION_MAX_COLUMNS]; /**< where column j is in live_columns, -1 if dead */
+    int n_live_columns;
+    int n_alive;
+    int lowest_alive_row; /**< bottom-most row with a monster alive, -1 if none */
+
+    int origin_x[FORMATION_MAX_ROWS]; /**< x of column 0 before the current step */
+    int origin_y[FORMATION_MAX_ROWS]; /**< y of the row */
+    int step_column[FORMATION_MAX_ROWS]; /**< columns below this one already took the current step */
+    int step_change[FORMATION_MAX_ROWS]; /**< horizontal change of the current step */
+    unsigned int steps[FORMATION_MAX_ROWS]; /**< steps the row finished since the board was reset */
+
+    int direction;
+    int march_row; /**< monster the march reaches next */
+    int march_column;
+    int march_wait_ms; /**< time left before the next alive monster moves */
+    int monster_delay_ms;
+} formation_t;
+
+/**
+ * @brief How the formation shoots during a wave. Every period_ms
+ * n_shooters distinct columns fire at once, from their bottom-most
+ * monster.
+ *
+ */
+typedef struct fire_pattern {
+    int period_ms;
+    int n_shooters;
+    int aimed; /**< 1 if the column above the spaceship fires first when alive */
+} fire_pattern_t;
+
+/**
+ * @brief Everything a match is made of. Only ever changed
+ * through the world functions, which never block nor touch
+ * anything outside of the world they are given.
+ *
+ */
+typedef struct world {
+    world_config_t config;
+    const wave_t *wave; /**< wave being played, never copied */
+
+    uint32_t tick;
+    rng_t shooter_rng; /**< picks the columns that fire */
+    rng_t mothership_rng; /**< draws the score of a mothership hit */
+    int leftover_ms; /**< part of the last step shorter than a tick */
+
+    int n_players;
+    int score1;
+    int score2;
+    int n_lives;
+
+    int spaceship_x;
+    int spaceship_y;
+
+    bullet_pool_t bullets;
+    fire_pattern_t fire;
+    int shoot_wait_ms; /**< time left before the monsters shoot */
+
+    formation_t formation;
+
+    int mothership_x;
+    int mothership_y;
+    int mothership_alive;
+    int mothership_direction;
+    int mothership_spawn_ms; /**< time since the mothership was last reset */
+
+    int bunker_x[N_BUNKERS];
+    int bunker_y[N_BUNKERS];
+    bunker_bitmap_t bunker[N_BUNKERS];
+
+    broadphase_t grid;
+
+    game_events_t events; /**< hits found during the last tick */
+    game_event_t shown[MAX_SHOWN_EVENTS]; /**< events of the last step, for effects only, later ones are dropped once full */
+    int n_shown;
+    uint32_t cues; /**< WORLD_CUE flags raised during the last step */
+    int status; /**< WORLD_PLAYING, WORLD_WAVE_CLEARED or WORLD_PLAYER_DEAD */
+} world_t;
+
+/**
+ * @brief Fills in the wave of the original game, with its formation
+ * grown or shrunk to the given size. Rows keep the types they had in
+ * the original formation of N_ROWS rows.
+ *
+ * @param wave Wave to fill in.
+ * @param n_rows Rows of the formation.
+ * @param n_columns Columns of the formation.
+ */
+void world_original_wave(wave_t *wave, int n_rows, int n_columns);
+
+/**
+ * @brief Sets up a world with an intact board and one player.
+ *
+ * @param world World to initiate.
+ * @param config Sizes of the board and the objects.
+ * @param wave First wave to play, must outlive its use by the world.
+ * @param seed Seed of the world's random numbers.
+ */
+void world_init(world_t *world, const world_config_t *config,
+                const wave_t *wave, uint32_t seed);
+
+/**
+ * @brief Restores the spaceship and mothership, removes every bullet
+ * and sets up the formation and bunkers of the given wave. Scores and
+ * lives are kept. The wave is only pointed to, so moving on to the next
+ * wave copies nothing.
+ *
+ * @param world World to reset.
+ * @param wave Wave to play, must outlive its use by the world.
+ * @param monster_delay_offset_ms Added to the march delay of the wave.
+ */
+void world_reset_board(world_t *world, const wave_t *wave,
+                       int monster_delay_offset_ms);
+
+/**
+ * @brief Starts a match from a fresh board.
+ *
+ * @param world World to start.
+ * @param n_players 1 against the AI or 2 with an opponent driving the mothership
+ * @param n_lives Lives the player starts with.
+ * @param score Score the player starts with.
+ * @param wave Wave to play, must outlive its use by the world.
+ * @param monster_delay_offset_ms Added to the march delay of the wave.
+ */
+void world_start_match(world_t *world, int n_players, int n_lives, int score,
+                       const wave_t *wave, int monster_delay_offset_ms);
+
+/**
+ * @brief Changes how the formation shoots, from its next volley on
+ * until the board is reset with the pattern of a wave.
+ * The original pattern is one random column every MONSTER_SHOOT_PERIOD.
+ *
+ * @param world World to change.
+ * @param fire Fire pattern, shooters beyond the columns alive are ignored.
+ */
+void world_set_fire_pattern(world_t *world, const fire_pattern_t *fire);
+
+/**
+ * @brief Advances the world by dt_ms in fixed ticks of WORLD_TICK_MS,
+ * time left over is carried to the next step. Bullets, the march,
+ * the monsters' shooting, the mothership and colisions all run from
+ * the world's own clocks, so the same inputs always give the same world.
+ *
+ * @param world World to advance.
+ * @param input Input held during the whole step.
+ * @param dt_ms Time elapsed since the last step.
+ */
+void world_step(world_t *world, const input_t *input, uint32_t dt_ms);
+
+/**
+ * @brief Gives the x coordinate of monster (i, j), columns before
+ * the row's step_column have already taken the current step.
+ *
+ * @param f Formation holding the monster.
+ * @param i Row of the monster.
+ * @param j Column of the monster.
+ * @return x coordinate of the monster.
+ */
+int world_monster_x(const formation_t *f, int i, int j);
+
+/**
+ * @brief Checks if monster (i, j) is alive.
+ *
+ * @param f Formation holding the monster.
+ * @param i Row of the monster.
+ * @param j Column of the monster.
+ * @return 1 if the monster is alive and 0 otherwise.
+ */
+int world_monster_alive(const formation_t *f, int i, int j);
+
+/**
+ * @brief Gives the frame monster (i, j) is drawn with. Alive monsters
+ * switch frame at every step they take, so it follows from the steps
+ * of the row.
+ *
+ * @param f Formation holding the monster.
+ * @param i Row of the monster.
+ * @param j Column of the monster.
+ * @return 0 or 1
+ */
+int world_monster_frame(const formation_t *f, int i, int j);
+
+/**
+ * @brief Checks if the player has a bullet in flight.
+ *
+ * @param world World to check.
+ * @return 1 if a spaceship bullet is alive and 0 otherwise.
+ */
+int world_spaceship_bullet_active(const world_t *world);
+
+#endif
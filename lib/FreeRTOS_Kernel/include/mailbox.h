@@ -0,0 +1,172 @@
+#ifndef MAILBOX_H
+#define MAILBOX_H
+
+#ifndef INC_FREERTOS_H
+#error "include FreeRTOS.h" must appear in source files before "include mailbox.h"
+#endif
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* Tasks that can block in xMailboxWaitForChange() on the same mailbox at
+once. */
+#ifndef configMAILBOX_MAX_WAITERS
+#define configMAILBOX_MAX_WAITERS 2
+#endif
+
+/* Returned by xMailboxWaitForChange() when configMAILBOX_MAX_WAITERS tasks
+are already waiting on the mailbox. */
+#define errMAILBOX_TOO_MANY_WAITERS ( ( BaseType_t ) -1 )
+
+/**
+ * Type by which mailboxes are referenced.  For example, a call to
+ * xMailboxCreate() returns a MailboxHandle_t variable that can then be used
+ * as a parameter to vMailboxWrite(), ulMailboxRead(), etc.
+ */
+typedef void *MailboxHandle_t;
+
+/**
+ * mailbox. h
+ * <pre>
+ MailboxHandle_t xMailboxCreate( UBaseType_t uxItemSize );
+ </pre>
+ *
+ * Creates a mailbox: a single value shared between tasks, meant to replace
+ * queues of length one that are only ever written with xQueueOverwrite() and
+ * read with xQueuePeek().  The value is guarded by a sequence counter instead
+ * of a critical section, so reading it never enters the scheduler.  Writers
+ * are serialised with a critical section, readers copy the value and retry
+ * if a write happened in the meantime.
+ *
+ * A mailbox starts with its value zeroed and its version at 0, every write
+ * increments the version.
+ *
+ * @param uxItemSize The size, in bytes, of the value the mailbox holds.
+ *
+ * @return A handle to the mailbox, or NULL if it could not be allocated.
+ *
+ * \ingroup MailboxManagement
+ */
+MailboxHandle_t xMailboxCreate(UBaseType_t uxItemSize) PRIVILEGED_FUNCTION;
+
+/**
+ * mailbox. h
+ * <pre>
+ void vMailboxWrite( MailboxHandle_t xMailbox, const void *pvValue );
+ </pre>
+ *
+ * Replaces the value of the mailbox and wakes up every task waiting for it
+ * to change.  Must not be called from an interrupt.
+ *
+ * @param xMailbox The mailbox to write.
+ *
+ * @param pvValue Pointer to the new value, uxItemSize bytes are copied.
+ *
+ * \ingroup MailboxManagement
+ */
+void vMailboxWrite(MailboxHandle_t xMailbox, const void *pvValue) PRIVILEGED_FUNCTION;
+
+/**
+ * mailbox. h
+ * <pre>
+ uint32_t ulMailboxRead( MailboxHandle_t xMailbox, void *pvBuffer );
+ </pre>
+ *
+ * Copies the current value of the mailbox without blocking nor entering a
+ * critical section.
+ *
+ * @param xMailbox The mailbox to read.
+ *
+ * @param pvBuffer Buffer the value is copied into.
+ *
+ * @return Version of the value that was copied, 0 if the mailbox was never
+ * written.
+ *
+ * \ingroup MailboxManagement
+ */
+uint32_t ulMailboxRead(MailboxHandle_t xMailbox, void *pvBuffer) PRIVILEGED_FUNCTION;
+
+/**
+ * mailbox. h
+ * <pre>
+ BaseType_t xMailboxReadIfChanged( MailboxHandle_t xMailbox,
+                                   void *pvBuffer,
+                                   uint32_t *pulVersion );
+ </pre>
+ *
+ * Copies the value of the mailbox only if it was written since the version
+ * the caller last saw, which lets a mailbox carry requests that must only be
+ * handled once.
+ *
+ * @param xMailbox The mailbox to read.
+ *
+ * @param pvBuffer Buffer the value is copied into, left untouched if the
+ * value did not change.
+ *
+ * @param pulVersion Version the caller last saw, updated to the version that
+ * was copied.
+ *
+ * @return pdTRUE if a newer value was copied, otherwise pdFALSE.
+ *
+ * \ingroup MailboxManagement
+ */
+BaseType_t xMailboxReadIfChanged(MailboxHandle_t xMailbox, void *pvBuffer,
+                                 uint32_t *pulVersion) PRIVILEGED_FUNCTION;
+
+/**
+ * mailbox. h
+ * <pre>
+ BaseType_t xMailboxWaitForChange( MailboxHandle_t xMailbox,
+                                   void *pvBuffer,
+                                   uint32_t *pulVersion,
+                                   TickType_t xTicksToWait );
+ </pre>
+ *
+ * Same as xMailboxReadIfChanged() but blocks until the mailbox is written if
+ * it has not been since the version the caller last saw.  Waiting tasks are
+ * woken up with a task notification, taken with ulTaskNotifyTake(), which
+ * clears the notification value of the calling task.  A task that also
+ * receives notifications for anything else, such as values sent with
+ * xTaskNotify(), loses them while it waits and must not call this function.
+ *
+ * @param xMailbox The mailbox to wait on.
+ *
+ * @param pvBuffer Buffer the value is copied into.
+ *
+ * @param pulVersion Version the caller last saw, updated to the version that
+ * was copied.
+ *
+ * @param xTicksToWait The maximum amount of time the task should block
+ * waiting for a new value.
+ *
+ * @return pdTRUE if a newer value was copied, pdFALSE if the wait timed out
+ * and errMAILBOX_TOO_MANY_WAITERS, without waiting, if
+ * configMAILBOX_MAX_WAITERS tasks are already waiting.  Only pdTRUE means
+ * that pvBuffer was written.
+ *
+ * \ingroup MailboxManagement
+ */
+BaseType_t xMailboxWaitForChange(MailboxHandle_t xMailbox, void *pvBuffer,
+                                 uint32_t *pulVersion,
+                                 TickType_t xTicksToWait) PRIVILEGED_FUNCTION;
+
+/**
+ * mailbox. h
+ * <pre>
+ void vMailboxDelete( MailboxHandle_t xMailbox );
+ </pre>
+ *
+ * Frees a mailbox.  No task may be waiting on it.
+ *
+ * @param xMailbox The mailbox to delete.
+ *
+ * \ingroup MailboxManagement
+ */
+void vMailboxDelete(MailboxHandle_t xMailbox) PRIVILEGED_FUNCTION;
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* MAILBOX_H */
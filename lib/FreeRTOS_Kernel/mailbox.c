@@ -0,0 +1,223 @@
+#include <string.h>
+
+#include "FreeRTOS.h"
+#include "task.h"
+#include "mailbox.h"
+
+#define mailboxWORD_SIZE        (sizeof(uint32_t))
+#define mailboxNO_WAITER        ((BaseType_t) -1)
+#define mailboxVALUE_CHANGED    ((BaseType_t) -2)
+
+/*
+ * The value is guarded by a sequence counter that is odd while a write is in
+ * progress.  A reader copies the value between two loads of the counter and
+ * starts again if a write started or finished in between, so it never waits
+ * on a writer nor touches the scheduler.  The value is kept as words that are
+ * copied with atomic loads and stores, so that a torn read is only ever
+ * thrown away and never undefined.
+ */
+typedef struct MailboxDefinition {
+    uint32_t ulSequence;        /*< Twice the version, plus one while a write is in progress. */
+    UBaseType_t uxItemSize;     /*< Size of the value in bytes. */
+    UBaseType_t uxWords;        /*< Size of the value in words, rounded up. */
+    TaskHandle_t xWaiters[configMAILBOX_MAX_WAITERS];   /*< Tasks blocked in xMailboxWaitForChange(). */
+    uint32_t ulValue[];
+} Mailbox_t;
+
+MailboxHandle_t xMailboxCreate(UBaseType_t uxItemSize)
+{
+    Mailbox_t *pxNewMailbox;
+    UBaseType_t uxWords;
+
+    configASSERT(uxItemSize > 0);
+
+    uxWords = (uxItemSize + mailboxWORD_SIZE - 1) / mailboxWORD_SIZE;
+    pxNewMailbox = (Mailbox_t *)pvPortMalloc(sizeof(Mailbox_t) +
+                                             uxWords * mailboxWORD_SIZE);
+
+    if (pxNewMailbox != NULL) {
+        memset(pxNewMailbox, 0, sizeof(Mailbox_t) + uxWords * mailboxWORD_SIZE);
+        pxNewMailbox->uxItemSize = uxItemSize;
+        pxNewMailbox->uxWords = uxWords;
+    }
+
+    return (MailboxHandle_t)pxNewMailbox;
+}
+
+void vMailboxWrite(MailboxHandle_t xMailbox, const void *pvValue)
+{
+    Mailbox_t *const pxMailbox = (Mailbox_t *)xMailbox;
+    TaskHandle_t xWaiters[configMAILBOX_MAX_WAITERS];
+    uint32_t ulSequence, ulWord;
+    UBaseType_t uxWord, uxBytes;
+    BaseType_t x;
+
+    configASSERT(pxMailbox);
+
+    /* Writers are rare, a critical section keeps them from interleaving and
+    lets the waiters be collected consistently with the new version. */
+    taskENTER_CRITICAL();
+    {
+        ulSequence = pxMailbox->ulSequence;
+        __atomic_store_n(&pxMailbox->ulSequence, ulSequence + 1, __ATOMIC_RELAXED);
+        __atomic_thread_fence(__ATOMIC_RELEASE);
+
+        for (uxWord = 0; uxWord < pxMailbox->uxWords; uxWord++) {
+            uxBytes = pxMailbox->uxItemSize - uxWord * mailboxWORD_SIZE;
+            if (uxBytes > mailboxWORD_SIZE) {
+                uxBytes = mailboxWORD_SIZE;
+            }
+            ulWord = 0;
+            memcpy(&ulWord, (const uint8_t *)pvValue + uxWord * mailboxWORD_SIZE,
+                   uxBytes);
+            __atomic_store_n(&pxMailbox->ulValue[uxWord], ulWord, __ATOMIC_RELAXED);
+        }
+
+        __atomic_store_n(&pxMailbox->ulSequence, ulSequence + 2, __ATOMIC_RELEASE);
+
+        for (x = 0; x < configMAILBOX_MAX_WAITERS; x++) {
+            xWaiters[x] = pxMailbox->xWaiters[x];
+        }
+    }
+    taskEXIT_CRITICAL();
+
+    /* Notifying can yield, so it is done outside of the critical section.  A
+    waiter that timed out in the meantime is left with a stale notification,
+    which only makes its next wait check the version once more. */
+    for (x = 0; x < configMAILBOX_MAX_WAITERS; x++) {
+        if (xWaiters[x] != NULL) {
+            (void)xTaskNotifyGive(xWaiters[x]);
+        }
+    }
+}
+
+uint32_t ulMailboxRead(MailboxHandle_t xMailbox, void *pvBuffer)
+{
+    Mailbox_t *const pxMailbox = (Mailbox_t *)xMailbox;
+    uint32_t ulSequence, ulWord;
+    UBaseType_t uxWord, uxBytes;
+
+    configASSERT(pxMailbox);
+
+    for (;;) {
+        ulSequence = __atomic_load_n(&pxMailbox->ulSequence, __ATOMIC_ACQUIRE);
+        if ((ulSequence & 1) != 0) {
+            /* Only seen if the writer was preempted on another core, it
+            finishes within its critical section. */
+            continue;
+        }
+
+        for (uxWord = 0; uxWord < pxMailbox->uxWords; uxWord++) {
+            uxBytes = pxMailbox->uxItemSize - uxWord * mailboxWORD_SIZE;
+            if (uxBytes > mailboxWORD_SIZE) {
+                uxBytes = mailboxWORD_SIZE;
+            }
+            ulWord = __atomic_load_n(&pxMailbox->ulValue[uxWord], __ATOMIC_RELAXED);
+            memcpy((uint8_t *)pvBuffer + uxWord * mailboxWORD_SIZE, &ulWord,
+                   uxBytes);
+        }
+
+        __atomic_thread_fence(__ATOMIC_ACQUIRE);
+        if (__atomic_load_n(&pxMailbox->ulSequence, __ATOMIC_RELAXED) == ulSequence) {
+            return ulSequence >> 1;
+        }
+    }
+}
+
+BaseType_t xMailboxReadIfChanged(MailboxHandle_t xMailbox, void *pvBuffer,
+                                 uint32_t *pulVersion)
+{
+    Mailbox_t *const pxMailbox = (Mailbox_t *)xMailbox;
+    uint32_t ulVersion;
+
+    configASSERT(pxMailbox);
+    configASSERT(pulVersion);
+
+    /* Cheap check first so that polling an unchanged mailbox copies
+    nothing. */
+    ulVersion = __atomic_load_n(&pxMailbox->ulSequence, __ATOMIC_RELAXED) >> 1;
+    if (ulVersion == *pulVersion) {
+        return pdFALSE;
+    }
+
+    *pulVersion = ulMailboxRead(xMailbox, pvBuffer);
+
+    return pdTRUE;
+}
+
+/*
+ * Registers the calling task as a waiter, unless the mailbox was written
+ * since ulVersion.  Returns the slot taken, mailboxVALUE_CHANGED or
+ * mailboxNO_WAITER if every slot is taken.
+ */
+static BaseType_t prvAddWaiter(Mailbox_t *pxMailbox, uint32_t ulVersion)
+{
+    BaseType_t x, xSlot = mailboxNO_WAITER;
+
+    taskENTER_CRITICAL();
+    {
+        if ((pxMailbox->ulSequence >> 1) != ulVersion) {
+            xSlot = mailboxVALUE_CHANGED;
+        } else {
+            for (x = 0; x < configMAILBOX_MAX_WAITERS; x++) {
+                if (pxMailbox->xWaiters[x] == NULL) {
+                    pxMailbox->xWaiters[x] = xTaskGetCurrentTaskHandle();
+                    xSlot = x;
+                    break;
+                }
+            }
+        }
+    }
+    taskEXIT_CRITICAL();
+
+    return xSlot;
+}
+
+BaseType_t xMailboxWaitForChange(MailboxHandle_t xMailbox, void *pvBuffer,
+                                 uint32_t *pulVersion, TickType_t xTicksToWait)
+{
+    Mailbox_t *const pxMailbox = (Mailbox_t *)xMailbox;
+    TimeOut_t xTimeOut;
+    BaseType_t xSlot;
+
+    configASSERT(pxMailbox);
+
+    vTaskSetTimeOutState(&xTimeOut);
+
+    for (;;) {
+        if (xMailboxReadIfChanged(xMailbox, pvBuffer, pulVersion) != pdFALSE) {
+            return pdTRUE;
+        }
+
+        if (xTaskCheckForTimeOut(&xTimeOut, &xTicksToWait) != pdFALSE) {
+            return pdFALSE;
+        }
+
+        xSlot = prvAddWaiter(pxMailbox, *pulVersion);
+        /* More waiters call for a larger configMAILBOX_MAX_WAITERS. */
+        configASSERT(xSlot != mailboxNO_WAITER);
+        if (xSlot == mailboxNO_WAITER) {
+            return errMAILBOX_TOO_MANY_WAITERS;
+        }
+        if (xSlot == mailboxVALUE_CHANGED) {
+            continue;
+        }
+
+        /* Registered before the version was checked again, so a write from
+        now on is bound to notify this task. */
+        (void)ulTaskNotifyTake(pdTRUE, xTicksToWait);
+
+        taskENTER_CRITICAL();
+        {
+            pxMailbox->xWaiters[xSlot] = NULL;
+        }
+        taskEXIT_CRITICAL();
+    }
+}
+
+void vMailboxDelete(MailboxHandle_t xMailbox)
+{
+    configASSERT(xMailbox);
+
+    vPortFree(xMailbox);
+}
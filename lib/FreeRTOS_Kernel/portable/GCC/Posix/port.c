@@ -60,7 +60,6 @@
 #include <errno.h>
 #include <sys/time.h>
 #include <time.h>
-#include <sys/times.h>
 #include <stdlib.h>
 #include <stdio.h>
 #include <unistd.h>
@@ -85,6 +84,8 @@ typedef struct THREAD_SUSPENSIONS {
     pthread_t hThread;
     xTaskHandle hTask;
     unsigned portBASE_TYPE uxCriticalNesting;
+    unsigned long ulRuns;           /* Times the thread was resumed to run the task. */
+    unsigned long ulPreemptions;    /* Times the tick switched away from the task. */
 } xThreadState;
 /*-----------------------------------------------------------*/
 
@@ -103,6 +104,10 @@ static volatile portBASE_TYPE xServicingTick = pdFALSE;
 static volatile portBASE_TYPE xPendYield = pdFALSE;
 static volatile portLONG lIndexOfLastAddedTask = 0;
 static volatile unsigned portBASE_TYPE uxCriticalNesting;
+/* Switches between two threads, each one costs a pair of signals. */
+static volatile unsigned long ulContextSwitches = 0;
+/* Run time stats are counted from the first call to vPortFindTicksPerSecond. */
+static struct timespec xRunTimeStart;
 /*-----------------------------------------------------------*/
 
 /*
@@ -121,6 +126,8 @@ static void prvSetTaskCriticalNesting(pthread_t xThreadId,
                                       unsigned portBASE_TYPE uxNesting);
 static unsigned portBASE_TYPE prvGetTaskCriticalNesting(pthread_t xThreadId);
 static void prvDeleteThread(void *xThreadId);
+static void prvCountSwitch(pthread_t xSuspended, pthread_t xResumed,
+                           portBASE_TYPE xPreempted);
 /*-----------------------------------------------------------*/
 
 /*
@@ -162,6 +169,8 @@ portSTACK_TYPE *pxPortInitialiseStack(portSTACK_TYPE *pxTopOfStack,
     vPortEnterCritical();
 
     lIndexOfLastAddedTask = prvGetFreeThreadState();
+    pxThreads[lIndexOfLastAddedTask].ulRuns = 0;
+    pxThreads[lIndexOfLastAddedTask].ulPreemptions = 0;
 
     /* Create the new pThread. */
     if (0 == pthread_mutex_lock(&xSingleThreadMutex)) {
@@ -325,6 +334,8 @@ void vPortYield(void)
                                       uxCriticalNesting);
             uxCriticalNesting =
                 prvGetTaskCriticalNesting(xTaskToResume);
+            ulContextSwitches++;
+            prvCountSwitch(xTaskToSuspend, xTaskToResume, pdFALSE);
             /* Switch tasks. */
             prvResumeThread(xTaskToResume);
             prvSuspendThread(xTaskToSuspend);
@@ -421,6 +432,8 @@ void vPortSystemTickHandler(int sig)
                                           uxCriticalNesting);
                 uxCriticalNesting = prvGetTaskCriticalNesting(
                                         xTaskToResume);
+                ulContextSwitches++;
+                prvCountSwitch(xTaskToSuspend, xTaskToResume, pdTRUE);
                 /* Resume next task. */
                 prvResumeThread(xTaskToResume);
                 /* Suspend the current task. */
@@ -721,24 +734,64 @@ void vPortAddTaskHandle(void *pxTaskHandle)
 
 void vPortFindTicksPerSecond(void)
 {
-    /* Needs to be reasonably high for accuracy. */
-    unsigned long ulTicksPerSecond = sysconf(_SC_CLK_TCK);
+    /* The counter is in microseconds of the monotonic clock, so a task
+    blocked in a host call still counts as running, and the run times of
+    all tasks add up to the time since the scheduler started. */
+    clock_gettime(CLOCK_MONOTONIC, &xRunTimeStart);
     printf("Timer Resolution for Run TimeStats is %ld ticks per second.\n",
-           ulTicksPerSecond);
+           1000000L);
 }
 /*-----------------------------------------------------------*/
 
 unsigned long ulPortGetTimerValue(void)
 {
-    struct tms xTimes;
-    unsigned long ulTotalTime = times(&xTimes);
-    /* Return the application code times.
-     * The timer only increases when the application code is actually running
-     * which means that the total execution times should add up to 100%.
-     */
-    return (unsigned long)xTimes.tms_utime;
+    struct timespec xNow;
+
+    /* The kernel keeps 32 bits of it, which wrap after 71 minutes. */
+    clock_gettime(CLOCK_MONOTONIC, &xNow);
+    return (unsigned long)((xNow.tv_sec - xRunTimeStart.tv_sec) * 1000000L +
+                           (xNow.tv_nsec - xRunTimeStart.tv_nsec) / 1000L);
+}
+/*-----------------------------------------------------------*/
+
+unsigned long ulPortGetContextSwitchCount(void)
+{
+    return ulContextSwitches;
+}
+/*-----------------------------------------------------------*/
+
+static void prvCountSwitch(pthread_t xSuspended, pthread_t xResumed,
+                           portBASE_TYPE xPreempted)
+{
+    portLONG lIndex;
+    for (lIndex = 0; lIndex < MAX_NUMBER_OF_TASKS; lIndex++) {
+        if ((pthread_t)NULL == pxThreads[lIndex].hThread) {
+            continue;
+        }
+        if (pxThreads[lIndex].hThread == xResumed) {
+            pxThreads[lIndex].ulRuns++;
+        }
+        else if ((pdTRUE == xPreempted) &&
+                 (pxThreads[lIndex].hThread == xSuspended)) {
+            pxThreads[lIndex].ulPreemptions++;
+        }
+    }
+}
+/*-----------------------------------------------------------*/
 
-    /* Should check ulTotalTime for being clock_t max minus 1. */
-    (void)ulTotalTime;
+void vPortGetTaskSwitchCounts(xTaskHandle hTask, unsigned long *pulRuns,
+                              unsigned long *pulPreemptions)
+{
+    portLONG lIndex;
+
+    *pulRuns = 0;
+    *pulPreemptions = 0;
+    for (lIndex = 0; lIndex < MAX_NUMBER_OF_TASKS; lIndex++) {
+        if (pxThreads[lIndex].hTask == hTask) {
+            *pulRuns = pxThreads[lIndex].ulRuns;
+            *pulPreemptions = pxThreads[lIndex].ulPreemptions;
+            break;
+        }
+    }
 }
 /*-----------------------------------------------------------*/
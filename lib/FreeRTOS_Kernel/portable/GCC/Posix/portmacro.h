@@ -173,12 +173,19 @@ extern void vPortAddTaskHandle(void *pxTaskHandle);
 #define SIG_TICK                    SIGPROF
 #define TIMER_TYPE                  ITIMER_PROF */
 
-/* Make use of times(man 2) to gather run-time statistics on the tasks. */
+/* Make use of CLOCK_MONOTONIC to gather run-time statistics on the tasks, in microseconds. */
 extern void vPortFindTicksPerSecond(void);
 #define portCONFIGURE_TIMER_FOR_RUN_TIME_STATS()    vPortFindTicksPerSecond()       /* Nothing to do because the timer is already present. */
 extern unsigned long ulPortGetTimerValue(void);
 #define portGET_RUN_TIME_COUNTER_VALUE()            ulPortGetTimerValue()           /* Query the System time stats for this process. */
 
+/* Number of times a thread was suspended for another one to run. */
+extern unsigned long ulPortGetContextSwitchCount(void);
+
+/* Number of times the task was switched to, and switched away from by the tick. */
+extern void vPortGetTaskSwitchCounts(void *hTask, unsigned long *pulRuns,
+                                     unsigned long *pulPreemptions);
+
 #ifdef __cplusplus
 }
 #endif
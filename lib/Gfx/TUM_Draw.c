@@ -34,6 +34,7 @@
 #include "TUM_Draw.h"
 #include "TUM_Font.h"
 #include "TUM_Utils.h"
+#include "triple_buffer.h"
 
 #define ONE_BYTE 8
 #define TWO_BYTES 16
@@ -66,6 +67,8 @@ typedef enum {
     DRAW_LOADED_IMAGE_CROP,
     DRAW_SCALED_IMAGE,
     DRAW_ARROW,
+    DRAW_UPDATE_STREAMING_IMAGE,
+    DRAW_LOADED_IMAGE_BATCH,
 } draw_job_type_t;
 
 typedef struct loaded_image {
@@ -80,6 +83,7 @@ typedef struct loaded_image {
     //TODO make this atomic
     unsigned int ref_count;
     unsigned char pending_free;
+    unsigned char streaming;
 
     struct loaded_image *next;
 } loaded_image_t;
@@ -217,6 +221,20 @@ typedef struct arrow_data {
     unsigned int colour;
 } arrow_data_t;
 
+typedef struct streaming_image_data {
+    loaded_image_t *img;
+    uint32_t *pixels;
+    int first_row;
+    int n_rows;
+} streaming_image_data_t;
+
+typedef struct loaded_image_batch_data {
+    loaded_image_t **imgs; /**< followed by the x and y coordinates */
+    signed short *x;
+    signed short *y;
+    unsigned int n;
+} loaded_image_batch_data_t;
+
 union data_u {
     clear_data_t clear;
     arc_data_t arc;
@@ -232,6 +250,8 @@ union data_u {
     scaled_image_data_t scaled_image;
     text_data_t text;
     arrow_data_t arrow;
+    streaming_image_data_t streaming_image;
+    loaded_image_batch_data_t loaded_image_batch;
 };
 
 typedef struct draw_job {
@@ -241,7 +261,23 @@ typedef struct draw_job {
     struct draw_job *next;
 } draw_job_t;
 
-draw_job_t job_list_head = { 0 };
+/**
+ * @brief Queued draw jobs of one frame, jobs are appended at the tail
+ *
+ */
+typedef struct draw_list {
+    draw_job_t head;
+    draw_job_t *tail; /**< NULL while the list is empty */
+} draw_list_t;
+
+/* Jobs are recorded into the back list by the drawing thread while the
+ * thread holding the GL context executes the front one, the third holds
+ * the last submitted frame.
+ */
+static draw_list_t draw_lists[3];
+static triple_buffer_t draw_list_buffer = {
+    .back = 0, .middle = 1, .front = 2,
+};
 
 struct global_offsets {
     int x;
@@ -290,33 +326,38 @@ void setErrorMessage(char *msg)
     PRINT_ERROR("[SDL Error] %s\n" #msg, (char *)SDL_GetError(),           \
                 ##__VA_ARGS__)
 
+static void appendDrawJob(draw_list_t *list, draw_job_t *job)
+{
+    job->next = NULL;
+    if (list->tail) {
+        list->tail->next = job;
+    }
+    else {
+        list->head.next = job;
+    }
+    list->tail = job;
+}
+
 static draw_job_t *pushDrawJob(void)
 {
-    draw_job_t *iterator;
     draw_job_t *job = calloc(1, sizeof(draw_job_t));
     if (job == NULL) {
         return NULL;
     }
 
-    for (iterator = &job_list_head; iterator->next;
-         iterator = iterator->next)
-        ;
-
-    iterator->next = job;
+    appendDrawJob(&draw_lists[vTripleBufferBack(&draw_list_buffer)], job);
 
     return job;
 }
 
-static draw_job_t *popDrawJob(void)
+static draw_job_t *popDrawJob(draw_list_t *list)
 {
-    draw_job_t *ret = job_list_head.next;
+    draw_job_t *ret = list->head.next;
 
     if (ret) {
-        if (ret->next) {
-            job_list_head.next = ret->next;
-        }
-        else {
-            job_list_head.next = NULL;
+        list->head.next = ret->next;
+        if (list->head.next == NULL) {
+            list->tail = NULL;
         }
     }
 
@@ -622,7 +663,9 @@ static int freeLoadedImage(loaded_image_t **img)
         }
 
         SDL_FreeSurface(delete->surf);
-        SDL_RWclose(delete->ops);
+        if (delete->ops) {
+            SDL_RWclose(delete->ops);
+        }
         SDL_DestroyTexture(delete->tex);
         free(delete->filename);
         free(delete);
@@ -661,6 +704,44 @@ int xDrawLoadedImage(loaded_image_t *img, SDL_Renderer *ren, signed short x,
                               img->h * img->scale);
 }
 
+static SDL_Texture *createStreamingTexture(loaded_image_t *img)
+{
+    SDL_Texture *tex = SDL_CreateTexture(renderer, SDL_PIXELFORMAT_ARGB8888,
+                                         SDL_TEXTUREACCESS_STREAMING,
+                                         img->w, img->h);
+    if (tex == NULL) {
+        return NULL;
+    }
+
+    SDL_SetTextureBlendMode(tex, SDL_BLENDMODE_BLEND);
+    SDL_UpdateTexture(tex, NULL, img->surf->pixels, img->surf->pitch);
+
+    return tex;
+}
+
+static int _updateStreamingImage(loaded_image_t *img, uint32_t *pixels,
+                                 int first_row, int n_rows)
+{
+    SDL_Rect rows = { .x = 0, .y = first_row, .w = img->w, .h = n_rows };
+    int row;
+
+    // Surface keeps a copy so the texture can be rebuilt on rebind
+    for (row = 0; row < n_rows; row++)
+        memcpy((uint8_t *)img->surf->pixels +
+               (first_row + row) * img->surf->pitch,
+               pixels + row * img->w, img->w * sizeof(uint32_t));
+
+    if (SDL_UpdateTexture(img->tex, &rows,
+                          (uint8_t *)img->surf->pixels +
+                          first_row * img->surf->pitch,
+                          img->surf->pitch)) {
+        PRINT_SDL_ERROR("Failed to update streaming image");
+        return -1;
+    }
+
+    return 0;
+}
+
 static int _drawScaledImage(SDL_Texture *tex, SDL_Renderer *ren, signed short x,
                             signed short y, float scale)
 {
@@ -776,6 +857,25 @@ static int _drawArrow(signed short x1, signed short y1, signed short x2,
     return 0;
 }
 
+static int _drawLoadedImageBatch(loaded_image_batch_data_t *batch,
+                                 int x_offset, int y_offset)
+{
+    unsigned int k;
+    int ret = 0;
+
+    // Every image is released even if one fails to draw
+    for (k = 0; k < batch->n; k++) {
+        if (xDrawLoadedImage(batch->imgs[k], renderer,
+                             batch->x[k] + x_offset,
+                             batch->y[k] + y_offset)) {
+            ret = -1;
+        }
+        vPutLoadedImage(batch->imgs[k]);
+    }
+
+    return ret;
+}
+
 static int vHandleDrawJob(draw_job_t *job)
 {
     int ret = 0;
@@ -897,6 +997,20 @@ static int vHandleDrawJob(draw_job_t *job)
                              job->data->arrow.head_length,
                              job->data->arrow.thickness,
                              job->data->arrow.colour);
+            break;
+        case DRAW_UPDATE_STREAMING_IMAGE:
+            ret = _updateStreamingImage(job->data->streaming_image.img,
+                                        job->data->streaming_image.pixels,
+                                        job->data->streaming_image.first_row,
+                                        job->data->streaming_image.n_rows);
+            free(job->data->streaming_image.pixels);
+            vPutLoadedImage(job->data->streaming_image.img);
+            break;
+        case DRAW_LOADED_IMAGE_BATCH:
+            ret = _drawLoadedImageBatch(&job->data->loaded_image_batch,
+                                        x_offset, y_offset);
+            free(job->data->loaded_image_batch.imgs);
+            break;
         default:
             break;
     }
@@ -905,6 +1019,81 @@ static int vHandleDrawJob(draw_job_t *job)
     return ret;
 }
 
+/**
+ * @brief Frees a job that is never executed along with everything it
+ * holds, as vHandleDrawJob would have.
+ */
+static void vDiscardDrawJob(draw_job_t *job)
+{
+    unsigned int k;
+
+    if (job->data) {
+        switch (job->type) {
+            case DRAW_TEXT:
+                free(job->data->text.str);
+                break;
+            case DRAW_IMAGE:
+                free(job->data->image.filename);
+                break;
+            case DRAW_LOADED_IMAGE:
+                vPutLoadedImage(job->data->loaded_image.img);
+                break;
+            case DRAW_LOADED_IMAGE_CROP:
+                vPutLoadedImage(job->data->loaded_image_crop.image);
+                break;
+            case DRAW_SCALED_IMAGE:
+                free(job->data->scaled_image.image.filename);
+                break;
+            case DRAW_UPDATE_STREAMING_IMAGE:
+                free(job->data->streaming_image.pixels);
+                vPutLoadedImage(job->data->streaming_image.img);
+                break;
+            case DRAW_LOADED_IMAGE_BATCH:
+                for (k = 0; k < job->data->loaded_image_batch.n; k++) {
+                    vPutLoadedImage(job->data->loaded_image_batch.imgs[k]);
+                }
+                free(job->data->loaded_image_batch.imgs);
+                break;
+            default:
+                break;
+        }
+        free(job->data);
+    }
+    free(job);
+}
+
+/**
+ * @brief Drops the jobs of a frame that was never executed, except the
+ * updates of streaming images. Those are kept at the start of the list,
+ * in order, since drawers only send the rows that changed and the
+ * texture would otherwise never catch up.
+ */
+static void vRecycleDrawList(draw_list_t *list)
+{
+    draw_list_t kept = { 0 };
+    draw_job_t *job;
+
+    while ((job = popDrawJob(list)) != NULL) {
+        if (job->type == DRAW_UPDATE_STREAMING_IMAGE) {
+            appendDrawJob(&kept, job);
+        }
+        else {
+            vDiscardDrawJob(job);
+        }
+    }
+
+    *list = kept;
+}
+
+void tumDrawSubmitFrame(void)
+{
+    vTripleBufferPublish(&draw_list_buffer);
+
+    // A submitted frame that was never presented is dropped, a presented
+    // one may still hold the jobs after one that failed
+    vRecycleDrawList(&draw_lists[vTripleBufferBack(&draw_list_buffer)]);
+}
+
 #define INIT_JOB(JOB, TYPE)                                                    \
     draw_job_t *JOB = pushDrawJob();                                       \
     if (!JOB)                                                              \
@@ -969,13 +1158,21 @@ int tumDrawUpdateScreen(void)
     memcpy(&last_time, &cur_time, sizeof(struct timespec));
 #endif //configFPS_LIMIT
 
-    if (job_list_head.next == NULL) {
+    // The front list only changes if a new frame was submitted
+    int front = draw_list_buffer.front;
+
+    if (vTripleBufferAcquire(&draw_list_buffer) == front) {
         goto err;
     }
 
+    draw_list_t *list = &draw_lists[draw_list_buffer.front];
     draw_job_t *tmp_job;
 
-    while ((tmp_job = popDrawJob()) != NULL) {
+    if (list->head.next == NULL) {
+        goto err;
+    }
+
+    while ((tmp_job = popDrawJob(list)) != NULL) {
         if (!tmp_job->data) {
             return -1;
         }
@@ -1094,8 +1291,11 @@ int tumDrawBindThread(void) // Should be called from the Drawing Thread
 
     renderer = SDL_CreateRenderer(window, -1,
                                   SDL_RENDERER_ACCELERATED |
-                                  SDL_RENDERER_TARGETTEXTURE |
-                                  SDL_RENDERER_PRESENTVSYNC);
+                                  SDL_RENDERER_TARGETTEXTURE
+#if (configVSYNC == 1)
+                                  | SDL_RENDERER_PRESENTVSYNC
+#endif //configVSYNC
+                                 );
 
     if (renderer == NULL) {
         PRINT_SDL_ERROR("Failed to create renderer");
@@ -1113,8 +1313,11 @@ int tumDrawBindThread(void) // Should be called from the Drawing Thread
     for (; iterator; iterator = iterator->next)
         if (iterator->tex) {
             SDL_DestroyTexture(iterator->tex);
-            iterator->tex = SDL_CreateTextureFromSurface(
-                                renderer, iterator->surf);
+            if (iterator->streaming)
+                iterator->tex = createStreamingTexture(iterator);
+            else
+                iterator->tex = SDL_CreateTextureFromSurface(
+                                    renderer, iterator->surf);
         }
 
     pthread_mutex_unlock(&loaded_images_lock);
@@ -1403,6 +1606,96 @@ image_handle_t tumDrawLoadImage(char *filename)
     return tumDrawLoadScaledImage(filename, 1);
 }
 
+image_handle_t tumDrawCreateStreamingImage(int width, int height)
+{
+    loaded_image_t *ret = calloc(1, sizeof(loaded_image_t));
+    if (ret == NULL) {
+        PRINT_ERROR("Failed to allocate streaming image");
+        goto err_alloc;
+    }
+
+    ret->w = width;
+    ret->h = height;
+    ret->scale = 1;
+    ret->streaming = 1;
+
+    ret->surf = SDL_CreateRGBSurfaceWithFormat(0, width, height, 32,
+                SDL_PIXELFORMAT_ARGB8888);
+    if (ret->surf == NULL) {
+        PRINT_SDL_ERROR("Failed to create streaming surface");
+        goto err_surf;
+    }
+
+    ret->tex = createStreamingTexture(ret);
+    if (ret->tex == NULL) {
+        PRINT_SDL_ERROR("Failed to create streaming texture");
+        goto err_tex;
+    }
+
+    pthread_mutex_lock(&loaded_images_lock);
+
+    loaded_image_t *iterator = &loaded_images_list;
+    for (; iterator->next; iterator = iterator->next)
+        ;
+    iterator->next = ret;
+
+    pthread_mutex_unlock(&loaded_images_lock);
+
+    return ret;
+
+err_tex:
+    SDL_FreeSurface(ret->surf);
+err_surf:
+    free(ret);
+err_alloc:
+    return NULL;
+}
+
+int tumDrawUpdateStreamingImage(image_handle_t img, uint32_t *pixels,
+                                int first_row, int n_rows)
+{
+    loaded_image_t *loaded_img = (loaded_image_t *)img;
+    uint32_t *copy;
+
+    if (img == NULL || !loaded_img->streaming) {
+        return -1;
+    }
+
+    if (first_row < 0 || n_rows <= 0 || first_row + n_rows > loaded_img->h) {
+        return -1;
+    }
+
+    // The rows are copied before the job is queued, a queued job
+    // must never be left without them
+    copy = (uint32_t *)calloc(n_rows * loaded_img->w, sizeof(uint32_t));
+    if (copy == NULL) {
+        return -1;
+    }
+
+    memcpy(copy, pixels, n_rows * loaded_img->w * sizeof(uint32_t));
+
+    /** INIT_JOB(job, DRAW_UPDATE_STREAMING_IMAGE); */
+    draw_job_t *job = pushDrawJob();
+    if (job == NULL) {
+        free(copy);
+        return -1;
+    }
+    union data_u *data = calloc(1, sizeof(union data_u));
+    if (data == NULL) {
+        logCriticalError("job->data alloc");
+    }
+    job->data = data;
+    job->type = DRAW_UPDATE_STREAMING_IMAGE;
+
+    loaded_img->ref_count++;
+    job->data->streaming_image.pixels = copy;
+    job->data->streaming_image.img = loaded_img;
+    job->data->streaming_image.first_row = first_row;
+    job->data->streaming_image.n_rows = n_rows;
+
+    return 0;
+}
+
 int tumDrawFreeLoadedImage(image_handle_t *img)
 {
     int ret = 0;
@@ -1434,6 +1727,50 @@ int tumDrawLoadedImage(image_handle_t img, signed short x, signed short y)
     return 0;
 }
 
+int tumDrawLoadedImages(const image_handle_t *imgs, const signed short *x,
+                        const signed short *y, unsigned int n)
+{
+    loaded_image_batch_data_t *batch;
+    unsigned int k;
+
+    if (imgs == NULL || x == NULL || y == NULL) {
+        return -1;
+    }
+
+    for (k = 0; k < n; k++) {
+        if (imgs[k] == NULL) {
+            return -1;
+        }
+    }
+
+    if (n == 0) {
+        return 0;
+    }
+
+    INIT_JOB(job, DRAW_LOADED_IMAGE_BATCH);
+
+    batch = &job->data->loaded_image_batch;
+
+    // One allocation holds the handles and both coordinate arrays
+    batch->imgs = malloc(n * (sizeof(loaded_image_t *) +
+                              2 * sizeof(signed short)));
+    if (batch->imgs == NULL) {
+        logCriticalError("image batch alloc");
+    }
+    batch->x = (signed short *)(batch->imgs + n);
+    batch->y = batch->x + n;
+    batch->n = n;
+
+    for (k = 0; k < n; k++) {
+        batch->imgs[k] = (loaded_image_t *)imgs[k];
+        batch->imgs[k]->ref_count++;
+    }
+    memcpy(batch->x, x, n * sizeof(signed short));
+    memcpy(batch->y, y, n * sizeof(signed short));
+
+    return 0;
+}
+
 int tumDrawSetLoadedImageScale(image_handle_t img, float scale)
 {
     if (img == NULL) {
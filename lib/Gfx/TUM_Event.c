@@ -23,6 +23,8 @@
 
 #include <linux/unistd.h>
 #include <assert.h>
+#include <string.h>
+#include <time.h>
 
 #include "TUM_Event.h"
 #include "task.h"
@@ -47,6 +49,14 @@ QueueHandle_t buttonInputQueue = NULL;
 
 mouse_t mouse;
 
+typedef struct input_stamps {
+    xSemaphoreHandle lock;
+    uint64_t us[INPUT_STAMPS_MAX];
+    unsigned int count;
+} input_stamps_t;
+
+static input_stamps_t input_stamps;
+
 xSemaphoreHandle fetch_lock;
 
 static int initMouse(void)
@@ -64,11 +74,40 @@ static int initMouse(void)
     return 0;
 }
 
+static uint64_t getMonotonicMicros(void)
+{
+    struct timespec now;
+
+    clock_gettime(CLOCK_MONOTONIC, &now);
+
+    return (uint64_t)now.tv_sec * 1000000 + now.tv_nsec / 1000;
+}
+
+/**
+ * @brief Remembers when a press happened. SDL stamps events in
+ * milliseconds since it started, the age of the event is taken off
+ * the monotonic clock so that the time it waited in SDL's queue counts
+ */
+static void stampInput(Uint32 timestamp, uint64_t now_us)
+{
+    Uint32 age_ms = SDL_GetTicks() - timestamp;
+
+    // Never blocks the fetching thread, a busy lock drops the stamp
+    if (xSemaphoreTake(input_stamps.lock, 0) == pdTRUE) {
+        if (input_stamps.count < INPUT_STAMPS_MAX) {
+            input_stamps.us[input_stamps.count++] =
+                now_us - (uint64_t)age_ms * 1000;
+        }
+        xSemaphoreGive(input_stamps.lock);
+    }
+}
+
 static void SDLFetchEvents(void)
 {
     SDL_Event event = { 0 };
     static unsigned char buttons[SDL_NUM_SCANCODES] = { 0 };
     unsigned char send = 0;
+    uint64_t now_us = getMonotonicMicros();
 
     while (SDL_PollEvent(&event)) {
         if ((event.type == SDL_QUIT) ||
@@ -77,6 +116,9 @@ static void SDLFetchEvents(void)
         }
         else if (event.type == SDL_KEYDOWN) {
             buttons[event.key.keysym.scancode] = 1;
+            if (!event.key.repeat) {
+                stampInput(event.key.timestamp, now_us);
+            }
             send = 1;
         }
         else if (event.type == SDL_KEYUP) {
@@ -91,6 +133,7 @@ static void SDLFetchEvents(void)
             }
         }
         else if (event.type == SDL_MOUSEBUTTONDOWN) {
+            stampInput(event.button.timestamp, now_us);
             if (xSemaphoreTake(mouse.lock, 0) == pdTRUE) {
                 switch (event.button.button) {
                     case SDL_BUTTON_LEFT:
@@ -225,6 +268,24 @@ signed char tumEventGetMouseMiddle(void)
     return ret;
 }
 
+int tumEventTakeInputStamps(uint64_t *stamps_us, int max)
+{
+    int n = 0;
+
+    // The presses are left for the next call if the fetch holds the lock
+    if (xSemaphoreTake(input_stamps.lock, 0) != pdTRUE) {
+        return 0;
+    }
+    if (stamps_us) {
+        n = input_stamps.count < (unsigned int)max ? input_stamps.count : max;
+        memcpy(stamps_us, input_stamps.us, n * sizeof(uint64_t));
+    }
+    input_stamps.count = 0;
+    xSemaphoreGive(input_stamps.lock);
+
+    return n;
+}
+
 int tumEventInit(void)
 {
     if (initMouse()) {
@@ -232,6 +293,12 @@ int tumEventInit(void)
         goto err_init_mouse;
     }
 
+    input_stamps.lock = xSemaphoreCreateMutex();
+    if (!input_stamps.lock) {
+        PRINT_ERROR("Creating input stamp lock failed");
+        goto err_stamps;
+    }
+
     buttonInputQueue =
         xQueueCreate(1, sizeof(unsigned char) * SDL_NUM_SCANCODES);
 
@@ -248,6 +315,8 @@ int tumEventInit(void)
     return 0;
 
 err_queue:
+    vSemaphoreDelete(input_stamps.lock);
+err_stamps:
     vSemaphoreDelete(mouse.lock);
 err_init_mouse:
     return -1;
@@ -256,5 +325,6 @@ err_init_mouse:
 void tumEventExit(void)
 {
     vQueueDelete(buttonInputQueue);
+    vSemaphoreDelete(input_stamps.lock);
     vSemaphoreDelete(mouse.lock);
 }
@@ -49,6 +49,8 @@
  * @{
  */
 
+#include <stdint.h>
+
 #include "EmulatorConfig.h"
 
 /**
@@ -188,10 +190,24 @@ int tumDrawBindThread(void);
 void tumDrawExit(void);
 
 /**
- * @brief Executes the queued draw jobs
+ * @brief Hands the draw jobs queued since the last call over to be
+ * executed by the next call to tumDrawUpdateScreen()
+ *
+ * Draw jobs are recorded into a list of their own while the previously
+ * submitted frame is executed, so drawing never waits for the screen
+ * to be updated. A submitted frame that is replaced before it is
+ * executed is dropped, apart from its tumDrawUpdateStreamingImage()
+ * updates, which are carried into the next frame. Jobs should be
+ * recorded and submitted from one thread at a time.
+ */
+void tumDrawSubmitFrame(void);
+
+/**
+ * @brief Executes the draw jobs of the last submitted frame
  *
  * The tumDraw primative draw functions are designed to be callable from any
  * thread, as such each function queues a draw job into a queue. Once
+ * the frame is submitted with tumDrawSubmitFrame() and
  * tumDrawUpdateScreen is called, the queued draw jobs are executed by the
  * background SDL thread.
  *
@@ -204,7 +220,7 @@ void tumDrawExit(void);
  * dependent calls, such as tumDrawUpdateScreen() will fail if the calling
  * thread does not hold the GL context.
  *
- * @returns 0 on success
+ * @returns 0 on success, -1 on error or if no new frame was submitted
  */
 int tumDrawUpdateScreen(void);
 
@@ -379,6 +395,31 @@ image_handle_t tumDrawLoadImage(char *filename);
  */
 image_handle_t tumDrawLoadScaledImage(char *filename, float scale);
 
+/**
+ * @brief Creates a blank, fully transparent image whose pixels can be
+ * rewritten at runtime using tumDrawUpdateStreamingImage(). The image is
+ * drawn like any other loaded image and closed using tumDrawFreeLoadedImage()
+ *
+ * @param width Width of the image in pixels
+ * @param height Height of the image in pixels
+ * @return Returns a image_handle_t handle to the image
+ */
+image_handle_t tumDrawCreateStreamingImage(int width, int height);
+
+/**
+ * @brief Replaces a band of rows of a streaming image. Only the given rows
+ * are uploaded to the texture, the pixels are copied so the buffer can be
+ * reused as soon as the function returns
+ *
+ * @param img Handle to an image created with tumDrawCreateStreamingImage()
+ * @param pixels ARGB8888 pixels of the rows, image width pixels per row
+ * @param first_row First row of the image to be replaced
+ * @param n_rows Number of rows to be replaced
+ * @return 0 on success
+ */
+int tumDrawUpdateStreamingImage(image_handle_t img, uint32_t *pixels,
+                                int first_row, int n_rows);
+
 /**
  * @brief Closes a loaded image and frees all memory used by the image structure
  *
@@ -444,6 +485,20 @@ int tumDrawGetLoadedImageSize(image_handle_t img, int *w, int *h);
  */
 int tumDrawLoadedImage(image_handle_t img, signed short x, signed short y);
 
+/**
+ * @brief Draws many loaded images to the screen as a single draw job, which
+ * costs one allocation and one trip through the job list however many images
+ * are drawn
+ *
+ * @param imgs Handles to the images to be drawn, one per position
+ * @param x X coordinates of the top left corner of each image
+ * @param y Y coordinates of the top left corner of each image
+ * @param n Number of images to be drawn
+ * @return 0 on success
+ */
+int tumDrawLoadedImages(const image_handle_t *imgs, const signed short *x,
+                        const signed short *y, unsigned int n);
+
 /**
  * @brief Draws an image on the screen
  *
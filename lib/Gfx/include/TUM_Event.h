@@ -142,6 +142,24 @@ signed char tumEventGetMouseMiddle(void);
  */
 int tumEventFetchEvents(int flags);
 
+/** Presses remembered by tumEventFetchEvents() until they are taken */
+#define INPUT_STAMPS_MAX 64
+
+/**
+ * @brief Takes the times at which the keys and mouse buttons were pressed
+ * since the last call, so that how long the press took to have an effect
+ * can be measured. Times are in microseconds of CLOCK_MONOTONIC and include
+ * the time the event waited in SDL's queue. Presses beyond INPUT_STAMPS_MAX
+ * are not remembered. Never blocks, if events are being fetched the presses
+ * are left for the next call.
+ *
+ * @param stamps_us Array the press times are copied into, in the order of
+ * the presses, NULL to only forget them
+ * @param max Size of the array
+ * @return Number of press times copied
+ */
+int tumEventTakeInputStamps(uint64_t *stamps_us, int max);
+
 /*!<
  * @brief FreeRTOS queue used to obtain a current copy of the keyboard lookup table
  *
@@ -0,0 +1,119 @@
+#include <stdint.h>
+#include <string.h>
+
+#include "broadphase.h"
+
+static int iClampCell(int coord, int shift, int n_cells)
+{
+    int cell = coord >> shift;
+
+    if (cell < 0)
+        return 0;
+    if (cell >= n_cells)
+        return n_cells - 1;
+
+    return cell;
+}
+
+static void vBroadphaseMark(broadphase_t *bp, int id, int set)
+{
+    broadphase_entity_t *e = &bp->entity[id];
+    uint64_t bit = 1ULL << (id % 64);
+    int cx, cy;
+
+    for (cy = e->cy0; cy <= e->cy1; cy++) {
+        for (cx = e->cx0; cx <= e->cx1; cx++) {
+            if (set)
+                bp->cell[cy][cx][id / 64] |= bit;
+            else
+                bp->cell[cy][cx][id / 64] &= ~bit;
+        }
+    }
+}
+
+static int iCellsCovering(int size, int shift)
+{
+    return (size + (1 << shift) - 1) >> shift;
+}
+
+void vBroadphaseInit(broadphase_t *bp, int width, int height)
+{
+    memset(bp, 0, sizeof(*bp));
+
+    bp->cell_shift = BROADPHASE_MIN_CELL_SHIFT;
+    while (iCellsCovering(width, bp->cell_shift) > BROADPHASE_MAX_CELLS_X
+            || iCellsCovering(height, bp->cell_shift) > BROADPHASE_MAX_CELLS_Y)
+        bp->cell_shift++;
+    bp->cells_x = iCellsCovering(width, bp->cell_shift);
+    bp->cells_y = iCellsCovering(height, bp->cell_shift);
+}
+
+void vBroadphaseUpdate(broadphase_t *bp, int id, int x, int y, int width, int height)
+{
+    broadphase_entity_t *e = &bp->entity[id];
+    int cx0 = iClampCell(x, bp->cell_shift, bp->cells_x);
+    int cy0 = iClampCell(y, bp->cell_shift, bp->cells_y);
+    int cx1 = iClampCell(x + width, bp->cell_shift, bp->cells_x);
+    int cy1 = iClampCell(y + height, bp->cell_shift, bp->cells_y);
+
+    e->x = x;
+    e->y = y;
+    e->width = width;
+    e->height = height;
+
+    //most moves stay inside the same cells
+    if (e->active && e->cx0 == cx0 && e->cy0 == cy0
+                  && e->cx1 == cx1 && e->cy1 == cy1)
+        return;
+
+    if (e->active)
+        vBroadphaseMark(bp, id, 0);
+
+    e->cx0 = cx0;
+    e->cy0 = cy0;
+    e->cx1 = cx1;
+    e->cy1 = cy1;
+    e->active = 1;
+    vBroadphaseMark(bp, id, 1);
+}
+
+void vBroadphaseRemove(broadphase_t *bp, int id)
+{
+    if (!bp->entity[id].active)
+        return;
+
+    vBroadphaseMark(bp, id, 0);
+    bp->entity[id].active = 0;
+}
+
+int vBroadphaseQuery(const broadphase_t *bp, int x0, int y0, int x1, int y1,
+                     uint64_t *candidates)
+{
+    int cx, cy, w, found = 0;
+    int cx0 = iClampCell(x0, bp->cell_shift, bp->cells_x);
+    int cy0 = iClampCell(y0, bp->cell_shift, bp->cells_y);
+    int cx1 = iClampCell(x1, bp->cell_shift, bp->cells_x);
+    int cy1 = iClampCell(y1, bp->cell_shift, bp->cells_y);
+
+    for (w = 0; w < BROADPHASE_WORDS; w++)
+        candidates[w] = 0;
+
+    for (cy = cy0; cy <= cy1; cy++) {
+        for (cx = cx0; cx <= cx1; cx++) {
+            for (w = 0; w < BROADPHASE_WORDS; w++)
+                candidates[w] |= bp->cell[cy][cx][w];
+        }
+    }
+
+    for (w = 0; w < BROADPHASE_WORDS; w++)
+        found |= candidates[w] != 0;
+
+    return found;
+}
+
+void vBroadphaseEndTick(broadphase_t *bp)
+{
+    bp->narrowphase_tests_last_tick = bp->narrowphase_tests;
+    bp->narrowphase_tests_total += bp->narrowphase_tests;
+    bp->narrowphase_tests = 0;
+}
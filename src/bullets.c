@@ -0,0 +1,99 @@
+#include <stdint.h>
+#include <string.h>
+
+#include "bullets.h"
+
+#define FREE_LIST_END 0xFFFF
+
+void vBulletPoolInit(bullet_pool_t *pool)
+{
+    int k;
+
+    memset(pool->alive, 0, sizeof(pool->alive));
+    memset(pool->count_by_type, 0, sizeof(pool->count_by_type));
+    pool->count = 0;
+
+    for (k = 0; k < MAX_BULLETS; k++) {
+        //generation 0 is never handed out so that no handle is 0
+        if (pool->generation[k] == 0)
+            pool->generation[k] = 1;
+        pool->next_free[k] = k + 1;
+    }
+    pool->next_free[MAX_BULLETS - 1] = FREE_LIST_END;
+    pool->free_head = 0;
+}
+
+bullet_handle_t vBulletPoolSpawn(bullet_pool_t *pool, int x, int y, int type)
+{
+    uint16_t k = pool->free_head;
+
+    if (k == FREE_LIST_END)
+        return BULLET_HANDLE_INVALID;
+
+    pool->free_head = pool->next_free[k];
+
+    pool->x[k] = x;
+    pool->y[k] = y;
+    pool->prev_y[k] = y;
+    pool->type[k] = type;
+    pool->alive[k / 64] |= 1ULL << (k % 64);
+    pool->count++;
+    pool->count_by_type[type]++;
+
+    return ((bullet_handle_t)pool->generation[k] << BULLET_INDEX_BITS) | k;
+}
+
+void vBulletPoolRemoveAt(bullet_pool_t *pool, int index)
+{
+    uint64_t bit = 1ULL << (index % 64);
+
+    if (!(pool->alive[index / 64] & bit))
+        return;
+
+    pool->alive[index / 64] &= ~bit;
+    pool->count--;
+    pool->count_by_type[pool->type[index]]--;
+
+    //invalidates outstanding handles to this slot
+    pool->generation[index]++;
+    if (pool->generation[index] == 0)
+        pool->generation[index] = 1;
+
+    pool->next_free[index] = pool->free_head;
+    pool->free_head = index;
+}
+
+int vBulletPoolResolve(const bullet_pool_t *pool, bullet_handle_t handle)
+{
+    int index = handle & BULLET_INDEX_MASK;
+
+    if (index >= MAX_BULLETS)
+        return -1;
+    if (pool->generation[index] != handle >> BULLET_INDEX_BITS)
+        return -1;
+    if (!(pool->alive[index / 64] & (1ULL << (index % 64))))
+        return -1;
+
+    return index;
+}
+
+int vBulletPoolNext(const bullet_pool_t *pool, int from)
+{
+    int word = from / 64;
+    uint64_t bits;
+
+    if (from >= MAX_BULLETS)
+        return -1;
+
+    //masks out the slots before from in the first word
+    bits = pool->alive[word] & (~0ULL << (from % 64));
+
+    while (!bits) {
+        word++;
+        if (word >= BULLET_POOL_WORDS)
+            return -1;
+        bits = pool->alive[word];
+    }
+
+    return word * 64 + __builtin_ctzll(bits);
+}
@@ -0,0 +1,144 @@
+#include <stdint.h>
+#include <string.h>
+
+#include "bunker_bitmap.h"
+
+//cells a to b of a row
+#define SPAN(a, b) ((((uint32_t)1 << ((b) - (a) + 1)) - 1) << (a))
+
+static const uint32_t bunker_shape[BUNKER_ROWS] = {
+    SPAN(4, 17),
+    SPAN(3, 18),
+    SPAN(2, 19),
+    SPAN(1, 20),
+    SPAN(0, 21), SPAN(0, 21), SPAN(0, 21), SPAN(0, 21),
+    SPAN(0, 21), SPAN(0, 21), SPAN(0, 21), SPAN(0, 21),
+    SPAN(0, 6) | SPAN(15, 21),
+    SPAN(0, 5) | SPAN(16, 21),
+    SPAN(0, 4) | SPAN(17, 21),
+    SPAN(0, 4) | SPAN(17, 21),
+};
+
+#define BLAST_SIZE 5
+#define BLAST_CENTER (BLAST_SIZE / 2)
+
+//ragged so that craters don't look stamped
+static const uint32_t blast_mask[BLAST_SIZE] = {
+    0x0A, 0x1F, 0x1E, 0x0F, 0x1A,
+};
+
+static int iCellRow(int y)
+{
+    if (y < 0)
+        return 0;
+    if (y >= BUNKER_HEIGHT)
+        return BUNKER_ROWS - 1;
+
+    return y >> BUNKER_CELL_SHIFT;
+}
+
+void vBunkerBitmapInit(bunker_bitmap_t *bitmap)
+{
+    memcpy(bitmap->row, bunker_shape, sizeof(bitmap->row));
+}
+
+int vBunkerBitmapSweep(const bunker_bitmap_t *bitmap, int x, int prev_y,
+                       int y, int height)
+{
+    uint32_t column;
+    int r, edge;
+
+    if (x < 0 || x >= BUNKER_WIDTH)
+        return -1;
+    column = (uint32_t)1 << (x >> BUNKER_CELL_SHIFT);
+
+    if (y <= prev_y) {//going up, the top leads
+        if (prev_y + height <= 0 || y >= BUNKER_HEIGHT)
+            return -1;
+        for (r = iCellRow(prev_y + height - 1); r >= iCellRow(y); r--) {
+            if (!(bitmap->row[r] & column))
+                continue;
+            edge = (r << BUNKER_CELL_SHIFT) + BUNKER_CELL_SIZE - 1;
+            return prev_y > edge ? prev_y - edge : 0;
+        }
+        return -1;
+    }
+
+    //going down, the bottom leads
+    if (prev_y >= BUNKER_HEIGHT || y + height <= 0)
+        return -1;
+    for (r = iCellRow(prev_y); r <= iCellRow(y + height - 1); r++) {
+        if (!(bitmap->row[r] & column))
+            continue;
+        edge = r << BUNKER_CELL_SHIFT;
+        return prev_y + height - 1 < edge ? edge - (prev_y + height - 1) : 0;
+    }
+    return -1;
+}
+
+void vBunkerBitmapErode(bunker_bitmap_t *bitmap, int x, int y)
+{
+    int r, i, shift;
+    uint32_t mask;
+
+    if (x < 0 || x >= BUNKER_WIDTH || y < 0 || y >= BUNKER_HEIGHT)
+        return;
+
+    shift = (x >> BUNKER_CELL_SHIFT) - BLAST_CENTER;
+
+    for (i = 0; i < BLAST_SIZE; i++) {
+        r = (y >> BUNKER_CELL_SHIFT) - BLAST_CENTER + i;
+        if (r < 0 || r >= BUNKER_ROWS)
+            continue;
+
+        mask = shift >= 0 ? blast_mask[i] << shift : blast_mask[i] >> -shift;
+        bitmap->row[r] &= ~mask;
+    }
+}
+
+int vBunkerBitmapEmpty(const bunker_bitmap_t *bitmap)
+{
+    uint32_t standing = 0;
+    int r;
+
+    for (r = 0; r < BUNKER_ROWS; r++)
+        standing |= bitmap->row[r];
+
+    return !standing;
+}
+
+int vBunkerBitmapDiff(const bunker_bitmap_t *shown, const bunker_bitmap_t *current,
+                      int *first_row, int *n_rows)
+{
+    uint32_t changed = 0;
+    int r;
+
+    for (r = 0; r < BUNKER_ROWS; r++)
+        if (shown->row[r] ^ current->row[r])
+            changed |= (uint32_t)1 << r;
+
+    if (!changed)
+        return 0;
+
+    *first_row = __builtin_ctz(changed);
+    *n_rows = 32 - __builtin_clz(changed) - *first_row;
+
+    return 1;
+}
+
+void vBunkerBitmapRasterise(const bunker_bitmap_t *bitmap, int first_row,
+                            int n_rows, uint32_t colour, uint32_t *pixels)
+{
+    int r, line, c;
+    uint32_t *out;
+
+    for (r = 0; r < n_rows; r++) {
+        out = pixels + r * BUNKER_CELL_SIZE * BUNKER_WIDTH;
+        for (c = 0; c < BUNKER_WIDTH; c++)
+            out[c] = (bitmap->row[first_row + r] >> (c >> BUNKER_CELL_SHIFT)) & 1
+                     ? colour : 0;
+        //the other lines of a row are copies of the first
+        for (line = 1; line < BUNKER_CELL_SIZE; line++)
+            memcpy(out + line * BUNKER_WIDTH, out, BUNKER_WIDTH * sizeof(uint32_t));
+    }
+}
@@ -0,0 +1,47 @@
+#include <stdint.h>
+
+#include "effects.h"
+
+void vEffectPoolInit(effect_pool_t *pool)
+{
+    pool->count = 0;
+}
+
+int vEffectPoolSpawn(effect_pool_t *pool, int x, int y, int image,
+                     uint32_t birth_tick, uint32_t lifetime_ticks)
+{
+    int k = pool->count;
+
+    if (k == MAX_EFFECTS)
+        return -1;
+
+    pool->x[k] = x;
+    pool->y[k] = y;
+    pool->image[k] = image;
+    pool->birth_tick[k] = birth_tick;
+    pool->lifetime_ticks[k] = lifetime_ticks;
+    pool->count++;
+
+    return 0;
+}
+
+void vEffectPoolExpire(effect_pool_t *pool, uint32_t tick)
+{
+    int k = 0, last;
+
+    while (k < pool->count) {
+        //unsigned difference so the tick may wrap
+        if (tick - pool->birth_tick[k] < pool->lifetime_ticks[k]) {
+            k++;
+            continue;
+        }
+
+        //the moved effect is checked on the next pass
+        last = --pool->count;
+        pool->x[k] = pool->x[last];
+        pool->y[k] = pool->y[last];
+        pool->image[k] = pool->image[last];
+        pool->birth_tick[k] = pool->birth_tick[last];
+        pool->lifetime_ticks[k] = pool->lifetime_ticks[last];
+    }
+}
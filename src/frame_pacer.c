@@ -0,0 +1,123 @@
+#include <stdint.h>
+#include <stdio.h>
+#include <string.h>
+
+#include "frame_pacer.h"
+
+void vFramePacerInit(frame_pacer_t *pacer, uint32_t rate_hz, uint64_t now_us)
+{
+    memset(pacer, 0, sizeof(*pacer));
+    pacer->period_us = 1000000 / (rate_hz ? rate_hz : 1);
+    pacer->deadline_us = now_us + pacer->period_us;
+}
+
+uint32_t ulFramePacerBegin(frame_pacer_t *pacer, uint64_t now_us)
+{
+    uint64_t skipped;
+
+    if (now_us < pacer->deadline_us)
+        return 0;
+
+    skipped = (now_us - pacer->deadline_us) / pacer->period_us + 1;
+    pacer->deadline_us += skipped * pacer->period_us;
+    pacer->skipped += skipped;
+
+    return skipped;
+}
+
+uint64_t ulFramePacerUntilNext(const frame_pacer_t *pacer, uint64_t now_us)
+{
+    uint64_t start_us = pacer->deadline_us - pacer->period_us;
+
+    return now_us < start_us ? start_us - now_us : 0;
+}
+
+void vFramePacerPresented(frame_pacer_t *pacer, uint64_t now_us)
+{
+    uint64_t frame_us, k;
+
+    if (now_us > pacer->deadline_us)
+        pacer->late++;
+
+    //the first frame has nothing to be timed against
+    if (pacer->presented_us) {
+        frame_us = now_us - pacer->presented_us;
+        k = frame_us / FRAME_PACER_BUCKET_US;
+        if (k >= FRAME_PACER_N_BUCKETS)
+            k = FRAME_PACER_N_BUCKETS - 1;
+        pacer->bucket[k]++;
+        pacer->n++;
+        pacer->sum_us += frame_us;
+        if (frame_us > pacer->max_us)
+            pacer->max_us = frame_us;
+    }
+
+    pacer->presented_us = now_us;
+    pacer->deadline_us += pacer->period_us;
+}
+
+void vFramePacerMissed(frame_pacer_t *pacer)
+{
+    pacer->missed++;
+    pacer->deadline_us += pacer->period_us;
+}
+
+void vFramePacerHeld(frame_pacer_t *pacer)
+{
+    pacer->presented_us = 0;
+    pacer->deadline_us += pacer->period_us;
+}
+
+/**
+ * @brief Gives the upper edge of the bucket holding the given
+ * fraction of the frame times.
+ *
+ */
+static double dFramePacerPercentileMs(const frame_pacer_t *pacer,
+                                      double fraction)
+{
+    uint64_t seen = 0;
+    int k;
+
+    for (k = 0; k < FRAME_PACER_N_BUCKETS; k++) {
+        seen += pacer->bucket[k];
+        if (seen >= fraction * pacer->n)
+            break;
+    }
+
+    return (k + 1) * FRAME_PACER_BUCKET_US / 1000.0;
+}
+
+void vFramePacerSummary(const frame_pacer_t *pacer, char *line, size_t size)
+{
+    char frames[128] = " no frames";
+
+    if (pacer->n)
+        snprintf(frames, sizeof(frames),
+                 " frames %llu mean %.2f ms p50 %.2f ms p99 %.2f ms max %.2f ms",
+                 (unsigned long long)pacer->n,
+                 pacer->sum_us / 1000.0 / pacer->n,
+                 dFramePacerPercentileMs(pacer, 0.5),
+                 dFramePacerPercentileMs(pacer, 0.99), pacer->max_us / 1000.0);
+
+    snprintf(line, size, "# target %.2f ms%s late %llu skipped %llu missed %llu",
+             pacer->period_us / 1000.0, frames,
+             (unsigned long long)pacer->late,
+             (unsigned long long)pacer->skipped,
+             (unsigned long long)pacer->missed);
+}
+
+void vFramePacerDump(const frame_pacer_t *pacer, FILE *fp)
+{
+    char line[256];
+    int k;
+
+    fprintf(fp, "bucket_ms,frames\n");
+    for (k = 0; k < FRAME_PACER_N_BUCKETS; k++)
+        if (pacer->bucket[k])
+            fprintf(fp, "%.2f,%u\n", k * FRAME_PACER_BUCKET_US / 1000.0,
+                    pacer->bucket[k]);
+
+    vFramePacerSummary(pacer, line, sizeof(line));
+    fprintf(fp, "%s\n", line);
+}
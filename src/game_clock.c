@@ -0,0 +1,92 @@
+#include <stdint.h>
+#include <time.h>
+
+#include "game_clock.h"
+
+uint64_t vGameClockHostMicros(void)
+{
+    struct timespec now;
+
+    clock_gettime(CLOCK_MONOTONIC, &now);
+
+    return (uint64_t)now.tv_sec * 1000000 + now.tv_nsec / 1000;
+}
+
+/**
+ * @brief Folds the time elapsed since the last change into the
+ * game time, so the scale or pause that follows only applies from
+ * host_us on.
+ *
+ */
+static void vGameClockRebase(game_clock_t *clock, uint64_t host_us)
+{
+    clock->game_us = vGameClockNow(clock, host_us);
+    clock->host_us = host_us;
+}
+
+void vGameClockInit(game_clock_t *clock, uint64_t host_us)
+{
+    clock->game_us = 0;
+    clock->host_us = host_us;
+    clock->scale = GAME_CLOCK_SCALE_ONE;
+    clock->paused = 0;
+}
+
+uint64_t vGameClockNow(const game_clock_t *clock, uint64_t host_us)
+{
+    if (clock->paused || host_us <= clock->host_us)
+        return clock->game_us;
+
+    return clock->game_us +
+           (host_us - clock->host_us) * clock->scale / GAME_CLOCK_SCALE_ONE;
+}
+
+void vGameClockPause(game_clock_t *clock, uint64_t host_us)
+{
+    vGameClockRebase(clock, host_us);
+    clock->paused = 1;
+}
+
+void vGameClockResume(game_clock_t *clock, uint64_t host_us)
+{
+    vGameClockRebase(clock, host_us);
+    clock->paused = 0;
+}
+
+void vGameClockSetScale(game_clock_t *clock, uint64_t host_us, uint32_t scale)
+{
+    vGameClockRebase(clock, host_us);
+    clock->scale = scale;
+}
+
+void vGameClockAdvance(game_clock_t *clock, uint64_t us)
+{
+    clock->game_us += us;
+}
+
+void vGameTimerStart(game_timer_t *timer, uint64_t now_us, uint64_t delay_us,
+                     uint64_t period_us)
+{
+    timer->deadline_us = now_us + delay_us;
+    timer->period_us = period_us;
+    timer->armed = 1;
+}
+
+unsigned int vGameTimerExpired(game_timer_t *timer, uint64_t now_us)
+{
+    uint64_t n;
+
+    if (!timer->armed || now_us < timer->deadline_us)
+        return 0;
+
+    if (!timer->period_us) {
+        timer->armed = 0;
+        return 1;
+    }
+
+    //later deadlines stay on the grid of the first one
+    n = (now_us - timer->deadline_us) / timer->period_us + 1;
+    timer->deadline_us += n * timer->period_us;
+
+    return n;
+}
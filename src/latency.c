@@ -0,0 +1,136 @@
+#include <stdint.h>
+#include <stdio.h>
+
+#include "latency.h"
+
+/**
+ * @brief A press consumed by the game logic that no presented
+ * frame showed yet.
+ *
+ */
+typedef struct pending_input {
+    uint64_t event_us;
+    uint64_t consumed_us;
+} pending_input_t;
+
+//single producer, the game logic, and single consumer, the presenter,
+//so head and tail are the only shared words and no lock is ever taken
+static pending_input_t pending[LATENCY_MAX_PENDING];
+static uint32_t head; /**< input sequence number of the last press consumed */
+static uint32_t tail; /**< input sequence number of the last press shown */
+static uint32_t frame_seq; /**< last press shown by the frame being drawn */
+static uint32_t dropped;
+
+static latency_histogram_t input_to_tick;
+static latency_histogram_t tick_to_screen;
+static latency_histogram_t input_to_screen;
+
+static void vLatencyRecord(latency_histogram_t *h, uint64_t us)
+{
+    uint64_t k = us / LATENCY_BUCKET_US;
+
+    h->bucket[k < LATENCY_N_BUCKETS ? k : LATENCY_N_BUCKETS - 1]++;
+    h->n++;
+    h->sum_us += us;
+    if (us > h->max_us)
+        h->max_us = us;
+}
+
+void vLatencyInputConsumed(const uint64_t *event_us, int n, uint64_t now_us)
+{
+    uint32_t shown = __atomic_load_n(&tail, __ATOMIC_ACQUIRE);
+    pending_input_t *p;
+    int k;
+
+    for (k = 0; k < n; k++) {
+        //nothing was presented for a while, the press is not measured
+        if (head - shown == LATENCY_MAX_PENDING) {
+            dropped++;
+            continue;
+        }
+        p = &pending[head % LATENCY_MAX_PENDING];
+        p->event_us = event_us[k] < now_us ? event_us[k] : now_us;
+        p->consumed_us = now_us;
+        __atomic_store_n(&head, head + 1, __ATOMIC_RELEASE);
+    }
+}
+
+uint32_t ulLatencyInputSeq(void)
+{
+    return head;
+}
+
+void vLatencyFrameDrawn(uint32_t input_seq)
+{
+    __atomic_store_n(&frame_seq, input_seq, __ATOMIC_RELAXED);
+}
+
+void vLatencyPresented(uint64_t now_us)
+{
+    uint32_t seq = __atomic_load_n(&frame_seq, __ATOMIC_RELAXED);
+    uint32_t consumed = __atomic_load_n(&head, __ATOMIC_ACQUIRE);
+    const pending_input_t *p;
+
+    //a frame never shows presses the logic has not published yet
+    if ((int32_t)(seq - consumed) > 0)
+        seq = consumed;
+
+    while ((int32_t)(seq - tail) > 0) {
+        p = &pending[tail % LATENCY_MAX_PENDING];
+        vLatencyRecord(&input_to_tick, p->consumed_us - p->event_us);
+        vLatencyRecord(&tick_to_screen, now_us - p->consumed_us);
+        vLatencyRecord(&input_to_screen, now_us - p->event_us);
+        __atomic_store_n(&tail, tail + 1, __ATOMIC_RELEASE);
+    }
+}
+
+/**
+ * @brief Gives the upper edge of the bucket holding the given
+ * fraction of the latencies.
+ *
+ */
+static double dLatencyPercentileMs(const latency_histogram_t *h, double fraction)
+{
+    uint64_t seen = 0;
+    int k;
+
+    for (k = 0; k < LATENCY_N_BUCKETS; k++) {
+        seen += h->bucket[k];
+        if (seen >= fraction * h->n)
+            break;
+    }
+
+    return (k + 1) * LATENCY_BUCKET_US / 1000.0;
+}
+
+static void vLatencySummary(FILE *fp, const char *name,
+                            const latency_histogram_t *h)
+{
+    if (!h->n) {
+        fprintf(fp, "# %s: no presses\n", name);
+        return;
+    }
+
+    fprintf(fp, "# %s: n %llu mean %.2f ms p50 %.0f ms p99 %.0f ms max %.2f ms\n",
+            name, (unsigned long long)h->n, h->sum_us / 1000.0 / h->n,
+            dLatencyPercentileMs(h, 0.5), dLatencyPercentileMs(h, 0.99),
+            h->max_us / 1000.0);
+}
+
+void vLatencyDump(FILE *fp)
+{
+    int k;
+
+    fprintf(fp, "bucket_ms,input_to_tick,tick_to_screen,input_to_screen\n");
+    for (k = 0; k < LATENCY_N_BUCKETS; k++)
+        if (input_to_tick.bucket[k] || tick_to_screen.bucket[k]
+                || input_to_screen.bucket[k])
+            fprintf(fp, "%d,%u,%u,%u\n", k * LATENCY_BUCKET_US / 1000,
+                    input_to_tick.bucket[k], tick_to_screen.bucket[k],
+                    input_to_screen.bucket[k]);
+
+    vLatencySummary(fp, "input to tick", &input_to_tick);
+    vLatencySummary(fp, "tick to screen", &tick_to_screen);
+    vLatencySummary(fp, "input to screen", &input_to_screen);
+    fprintf(fp, "# dropped %u\n", dropped);
+}
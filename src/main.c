@@ -2,12 +2,14 @@
 #include <stdlib.h>
 #include <math.h>
 #include <time.h>
+#include <unistd.h>
 #include "string.h"
 
 #include <SDL2/SDL_scancode.h>
 
 #include "FreeRTOS.h"
 #include "queue.h"
+#include "mailbox.h"
 #include "semphr.h"
 #include "task.h"
 #include "timers.h"
@@ -26,13 +28,17 @@
 #include "text.h"
 #include "objects.h"
 #include "pvp.h"
+#include "game_clock.h"
+#include "wave_pack.h"
+#include "latency.h"
+#include "replay.h"
+#include "frame_pacer.h"
+#include "run_stats.h"
 
 #define mainGENERIC_PRIORITY (tskIDLE_PRIORITY)
 #define mainGENERIC_STACK_SIZE ((unsigned short)2560)
 #define STACK_SIZE mainGENERIC_STACK_SIZE * 2
 
-#define UNITARY_QUEUE_LENGHT 1
-
 #define STATE_COUNT 3
 
 #define MENU 0
@@ -41,56 +47,59 @@
 
 #define NEXT_TASK 0
 #define PREV_TASK 1
+#define NO_STATE_CHANGE -1
 
 #define STARTING_STATE MENU
 
 #define STATE_DEBOUNCE_DELAY 300
 
+#define FAST_FORWARD_MS 10000
+
+#define RUN_STATS_PERIOD_MS 1000
+#define RUN_STATS_POLL_MS 100
+
 #define KEYCODE(CHAR) SDL_SCANCODE_##CHAR
 #define BACKGROUND_COLOUR Black
 
-#define GREEN_LINE_Y SCREEN_HEIGHT - 38
-#define TOP_LINE_Y 75
-
 #ifdef TRACE_FUNCTIONS
 #include "tracer.h"
 #endif
 
-const unsigned char next_state_signal = NEXT_TASK;
-const unsigned char prev_state_signal = PREV_TASK;
-
-static TaskHandle_t StateMachine = NULL;
 static TaskHandle_t BufferSwap = NULL;
-static TaskHandle_t MenuDrawer = NULL;
-static TaskHandle_t GameLogic = NULL;
-static TaskHandle_t GameDrawer = NULL;
-static TaskHandle_t EnemyBulletShooter = NULL;
-static TaskHandle_t MonsterMover = NULL;
-static TaskHandle_t PauseDrawer = NULL;
-static TaskHandle_t CheckInputSetScore = NULL;
-
-TimerHandle_t xMothershipTimer;
+static TaskHandle_t GameLoop = NULL;
+static TaskHandle_t RunStatsReporter = NULL;
 
-static StaticTask_t GameDrawerBuffer;
+static StaticTask_t GameLoopBuffer;
 static StackType_t xStack[STACK_SIZE];
 
-static QueueHandle_t StateChangeQueue = NULL;
-static QueueHandle_t CurrentStateQueue = NULL;
-QueueHandle_t BulletQueue = NULL;
-QueueHandle_t ColisionQueue = NULL;
-QueueHandle_t MonsterDelayQueue = NULL;
-QueueHandle_t TimerStartingQueue = NULL;
+//written by the game loop, read by the network callbacks
+static MailboxHandle_t CurrentStateMailbox = NULL;
+
+//only touched by the game loop
+static unsigned char current_state = STARTING_STATE;
+static int state_change = NO_STATE_CHANGE;
+//the menu reads the starting score instead of its usual keys
+static int entering_score;
 
 static image_handle_t spaceship_image = NULL;
 static image_handle_t monster_image[3] = {NULL};
-static image_handle_t colision_image[2] = {NULL};
+static image_handle_t effect_image[N_EFFECT_IMAGES] = {NULL};
 static image_handle_t mothership_image = NULL;
-static image_handle_t bunker_image[6] = {NULL};
 
 static spritesheet_handle_t monster_spritesheet[3] = {NULL};
 
-static SemaphoreHandle_t DrawSignal = NULL;
-static SemaphoreHandle_t ScreenLock = NULL;
+//periods a late frame is still waited for before it is given up
+#define FRAME_LATE_LIMIT 4
+
+//frames are asked for by the swap task and drawn by the game loop,
+//each side only counts what it sees
+static frame_pacer_t frame_pacer;
+static unsigned long frames_skipped;
+static uint32_t frame_rate = configFPS_LIMIT_RATE;
+//set by the game loop, the swap task prints the frame times
+static int frame_times_wanted;
+//last frame the game loop left the screen as it was for
+static uint32_t held_frame;
 
 aIO_handle_t UDP_receive_handle = NULL;
 aIO_handle_t UDP_transmit_handle = NULL;
@@ -106,13 +115,62 @@ player_t my_player = { 0 };
 
 saved_values_t saved = { 0 };
 
-spaceship_t my_spaceship = { 0 };
+//only touched by the game loop once the scheduler runs
+static world_t my_world;
+static uint64_t last_step_ms;
 
-monster_grid_t my_monsters = { 0 };
+//only touched by the game loop once the scheduler runs
+static game_clock_t game_clock;
 
-mothership_t my_mothership = { 0 };
+/**
+ * @brief Gets the game time, which only runs while a match is played.
+ * 
+ * @return Game time in microseconds.
+ */
+static uint64_t xGetGameTime(void)
+{
+    return vGameClockNow(&game_clock, vGameClockHostMicros());
+}
 
-bunker_grid_t my_bunkers = { 0 };
+/**
+ * @brief Stops the game time, and with it the world and every
+ * game timer, until vResumeGameClock is called.
+ * 
+ */
+static void vPauseGameClock(void)
+{
+    vGameClockPause(&game_clock, vGameClockHostMicros());
+}
+
+static void vResumeGameClock(void)
+{
+    vGameClockResume(&game_clock, vGameClockHostMicros());
+}
+
+static world_config_t world_config = {
+    .board_width = SCREEN_WIDTH,
+    .board_height = SCREEN_HEIGHT,
+};
+
+//mapped once at startup, the original wave is played without it
+static wave_pack_t wave_pack;
+static wave_t original_wave;
+//only touched by the game loop once the scheduler runs
+static unsigned int wave_index;
+
+//only written by the game loop, recorded if a path is given
+static replay_t replay;
+
+/**
+ * @brief Gets the wave to play after wave_index waves were cleared.
+ * 
+ */
+static const wave_t *xGetWave(unsigned int index)
+{
+    const wave_t *wave = vWavePackWave(&wave_pack, index);
+
+    return wave ? wave : &original_wave;
+}
 
 void checkDraw(unsigned char status, const char *msg)
 {
@@ -135,6 +193,7 @@ void vCheckCoinInput(void)
 			if (!debounce_flag) {
                 debounce_flag = 1;
                 vInsertCoin();
+                vReplayMark(&replay, REPLAY_COIN);
                 prints("Coin Inserted.\n");
             }
 		} else {
@@ -144,26 +203,6 @@ void vCheckCoinInput(void)
 	}
 }
 
-void vResetGameBoard(void)
-{
-    int current_state;
-
-    vResetBulletQueue();
-    vResetColisionQueue();
-    vResetMonsters();
-    vResetMonsterDelay();
-    vResetSpaceship();
-    vResetBunkers();
-
-    xQueuePeek(CurrentStateQueue, &current_state, portMAX_DELAY);
-    if (my_player.n_players == 1 && current_state == GAME) {
-        vResetMothership();
-        vKillMothership();
-        xTimerReset(xMothershipTimer, portMAX_DELAY);
-    } else if (my_player.n_players == 2)
-        vSetUpMothershipPVP();
-}
-
 void xGetButtonInput(void)
 {
 	if (xSemaphoreTake(buttons.lock, 0) == pdTRUE) {
@@ -172,18 +211,24 @@ void xGetButtonInput(void)
 	}
 }
 
-void vPauseOrUnpauseGame(void)
+/**
+ * @brief Asks the game loop to change state once the current
+ * state is handled.
+ * 
+ * @param direction NEXT_TASK or PREV_TASK
+ */
+void vRequestStateChange(int direction)
 {
-    unsigned char current_state;
+    state_change = direction;
+}
 
-    if (xQueuePeek(CurrentStateQueue, &current_state, 0) ==
-		pdTRUE) {
-            if (current_state == GAME) {
-                xQueueSend(StateChangeQueue, &next_state_signal, 0);
-            } else if (current_state == PAUSE) {
-                xQueueSend(StateChangeQueue, &prev_state_signal, 0);
-            }
-	}
+void vPauseOrUnpauseGame(void)
+{
+    if (current_state == GAME) {
+        vRequestStateChange(NEXT_TASK);
+    } else if (current_state == PAUSE) {
+        vRequestStateChange(PREV_TASK);
+    }
 }
 
 static int vCheckPauseInput(void)
@@ -191,13 +236,9 @@ static int vCheckPauseInput(void)
 	if (xSemaphoreTake(buttons.lock, 0) == pdTRUE) {
 		if (buttons.buttons[KEYCODE(P)]) {
 			buttons.buttons[KEYCODE(P)] = 0;
-			if (StateChangeQueue) {
-				xSemaphoreGive(buttons.lock);
-                vPauseOrUnpauseGame();
-				return 1;
-			}
 			xSemaphoreGive(buttons.lock);
-			return 0;
+            vPauseOrUnpauseGame();
+			return 1;
 		}
 		xSemaphoreGive(buttons.lock);
 	}
@@ -205,66 +246,46 @@ static int vCheckPauseInput(void)
 	return 0;
 }
 
-void vPlayOrQuitGame(void)
+/**
+ * @brief Asks the swap task to print the frame times so far when F
+ * is pressed, in any state.
+ * 
+ */
+static void vCheckFrameTimesInput(void)
 {
-    unsigned char current_state;
-
-    if (xQueuePeek(CurrentStateQueue, &current_state, 0) ==
-			            pdTRUE) {
-        if (current_state == MENU && my_player.credits > 0) {
-            vUseCoin();
-            xQueueSend(StateChangeQueue, &next_state_signal, 0);
-        } else if (current_state == GAME) {
-            xQueueSend(StateChangeQueue, &prev_state_signal, 0);
-        }
+	if (xSemaphoreTake(buttons.lock, 0) == pdTRUE) {
+		if (buttons.buttons[KEYCODE(F)]) {
+			buttons.buttons[KEYCODE(F)] = 0;
+            __atomic_store_n(&frame_times_wanted, 1, __ATOMIC_RELEASE);
+		}
+		xSemaphoreGive(buttons.lock);
 	}
 }
 
+void vPlayOrQuitGame(void)
+{
+    if (current_state == MENU && my_player.credits > 0) {
+        vUseCoin();
+        vRequestStateChange(NEXT_TASK);
+    } else if (current_state == GAME) {
+        vRequestStateChange(PREV_TASK);
+    }
+}
+
 static int vCheckStateInput(void)
 {
 	if (xSemaphoreTake(buttons.lock, 0) == pdTRUE) {
 		if (buttons.buttons[KEYCODE(M)]) {
 			buttons.buttons[KEYCODE(M)] = 0;
-			if (StateChangeQueue) {
-				xSemaphoreGive(buttons.lock);
-                vPlayOrQuitGame();
-				return 1;
-			}
 			xSemaphoreGive(buttons.lock);
-			return 0;
+            vPlayOrQuitGame();
+			return 1;
 		}
 		xSemaphoreGive(buttons.lock);
 	}
 	return 0;
 }
 
-//suspends all tasks except 
-//screendrawer task and state machine tast
-void vSuspendAllTasks()
-{
-	if (MenuDrawer) {
-		vTaskSuspend(MenuDrawer);
-	}
-	if (GameDrawer) {
-		vTaskSuspend(GameDrawer);
-	}
-	if (GameLogic) {
-		vTaskSuspend(GameLogic);
-	}
-    if (EnemyBulletShooter) {
-		vTaskSuspend(EnemyBulletShooter);
-    }
-    if (MonsterMover) {
-		vTaskSuspend(MonsterMover);
-    }
-    if (PauseDrawer) {
-		vTaskSuspend(PauseDrawer);
-    }
-    if (CheckInputSetScore) {
-		vTaskSuspend(CheckInputSetScore);
-    }
-}
-
 /*
  * Changes the state, either forwards of backwards
  */
@@ -290,199 +311,254 @@ void changeState(volatile unsigned char *state, unsigned char forwards)
 	}
 }
 
-void vSwitchToMenu(unsigned char prev_state)
+void vStartMatch(int n_players)
 {
-    if (prev_state == GAME) {
-        vResetGameBoard();
-        vResetPlayer();
-        if (my_player.n_players == 1)
-            xTimerStop(xMothershipTimer, portMAX_DELAY);
-            prints("Match exited.\n");
-    }
-	if (MenuDrawer) {
-		vTaskResume(MenuDrawer);
-	}
+    int n_lives, score;
+
+    xSemaphoreTake(my_player.lock, portMAX_DELAY);
+    n_lives = my_player.n_lives;
+    score = my_player.score1;
+    xSemaphoreGive(my_player.lock);
+
+    wave_index = 0;
+    vReplayStartMatch(&replay, n_players, n_lives, score,
+                      xGetWave(wave_index), saved.offset);
+    world_start_match(&my_world, n_players, n_lives, score,
+                      xGetWave(wave_index), saved.offset);
 }
 
-void vResumeGameTasks(void)
+void vSwitchToMenu(unsigned char prev_state)
 {
-    if (GameDrawer) {
-		vTaskResume(GameDrawer);
-	}
-	if (GameLogic) {
-		vTaskResume(GameLogic);
-    }
-    if (EnemyBulletShooter) {
-		vTaskResume(EnemyBulletShooter);
-    }
-    if (MonsterMover) {
-		vTaskResume(MonsterMover);
+    //the effects are dropped when the next match starts
+    if (prev_state == GAME) {
+        vResetPlayer();
+        prints("Match exited.\n");
     }
 }
 
-void vSwitchToGame(unsigned char prev_state,
-         unsigned char current_state, TickType_t timer_elapsed)
+void vSwitchToGame(unsigned char prev_state, unsigned char current_state)
 {
     if (prev_state == MENU || prev_state == current_state) {
-        if (my_player.n_players == 1) {
-            vKillMothership();
-            xTimerReset(xMothershipTimer, portMAX_DELAY);
-        }
-        if (my_player.n_players == 2) {
-            vSetUpMothershipPVP();
+        vResetEffects();
+        vStartMatch(my_player.n_players);
+        if (my_player.n_players == 2)
             prints("2 Players selected.\n");
-        }
         prints("Match started! Good luck and Have fun!\n");
     }
-    if (prev_state == PAUSE) {
-        if (my_player.n_players == 1)
-            xTimerChangePeriod(xMothershipTimer, ORIGINAL_TIMER - timer_elapsed, portMAX_DELAY);
-            prints("Game unpaused.\n");
-    }
-    vResumeGameTasks();
+    //the world and every game timer only advance with the game clock
+    if (prev_state == PAUSE)
+        prints("Game unpaused.\n");
+    //presses made outside of the match never reach it
+    tumEventTakeInputStamps(NULL, 0);
+    vResumeGameClock();
 }
 
-void vSwitchToPause(unsigned char prev_state,
-             TickType_t *timer_starting, TickType_t *timer_elapsed)
+void vSwitchToPause(unsigned char prev_state)
 {
     if (prev_state == GAME) {
-        if (my_player.n_players == 1) {
-            xTimerStop(xMothershipTimer, portMAX_DELAY);
-            *timer_starting = xQueuePeek(TimerStartingQueue, timer_starting, portMAX_DELAY);
-            *timer_elapsed = xTaskGetTickCount() - *timer_starting;
-        }
         prints("Game paused.\n");
-    }
-    if (PauseDrawer) {
-		vTaskResume(PauseDrawer);
+        vReplayMark(&replay, REPLAY_PAUSE);
     }
 }
 
-void basicSequentialStateMachine(void *pvParameters)
+/**
+ * @brief Changes to the state asked for while the current one was
+ * handled, unless the last change was too recent. The game clock
+ * stops on every change and only the game starts it again.
+ * 
+ */
+void vCheckStateChange(void)
 {
-	unsigned char current_state = STARTING_STATE;//Default state
-    unsigned char prev_state = STARTING_STATE;
-	unsigned char state_changed =
-		1; // Only re-evaluate state if it has changed
-	unsigned char input = 0;
-
-	const int state_change_period = STATE_DEBOUNCE_DELAY;
+    static TickType_t last_change = 0;
+    unsigned char prev_state = current_state;
 
-	TickType_t last_change, timer_elapsed, timer_starting;
-
-    last_change = xTaskGetTickCount();
+    if (state_change == NO_STATE_CHANGE)
+        return;
 
-    xQueueOverwrite(CurrentStateQueue,
-							&current_state);
+    if (xTaskGetTickCount() - last_change > STATE_DEBOUNCE_DELAY) {
+        changeState(&current_state, state_change);
+        vMailboxWrite(CurrentStateMailbox, &current_state);
+        last_change = xTaskGetTickCount();
 
-	while (1) {
-		if (state_changed) {
-			goto initial_state;
-		}
-
-		// Handle state machine input
-		if (StateChangeQueue)
-			if (xQueueReceive(StateChangeQueue, &input,
-					  portMAX_DELAY) == pdTRUE)
-				if (xTaskGetTickCount() - last_change >
-				    state_change_period) {
-                    prev_state = current_state;
-					changeState(&current_state, input);
-					xQueueOverwrite(CurrentStateQueue,
-							&current_state);
-					state_changed = 1;
-					last_change = xTaskGetTickCount();
-				}
-
-	initial_state:
-		// Handle current state
-		if (state_changed) {
-			vSuspendAllTasks();
-			switch (current_state) {
-			case MENU:
+        vPauseGameClock();
+        switch (current_state) {
+            case MENU:
                 vSwitchToMenu(prev_state);
-				break;
-			case GAME:
-                vSwitchToGame(prev_state, current_state, timer_elapsed);
-				break;
+                break;
+            case GAME:
+                vSwitchToGame(prev_state, current_state);
+                break;
             case PAUSE:
-                vSwitchToPause(prev_state, &timer_starting, &timer_elapsed);
+                vSwitchToPause(prev_state);
                 break;
-			default:
-				break;
-			}
-			state_changed = 0;
-		}
-	}
+            default:
+                break;
+        }
+    }
+    state_change = NO_STATE_CHANGE;
 }
 
+/**
+ * @brief Asks the game loop for a numbered frame and presents it once
+ * the game loop notifies that exactly this frame is drawn. The frame
+ * pacer is the only limit on the frame rate. A frame drawn late is
+ * still presented, and the frames whose period went by meanwhile are
+ * never asked for, so the game loop draws less to catch up. A frame
+ * that is not drawn at all is not presented, so a half drawn frame
+ * never reaches the screen. A frame the game loop holds leaves the
+ * screen as it was and is neither presented nor missed.
+ * 
+ */
 void vSwapBuffers(void *pvParameters)
 {
-	TickType_t xLastWakeTime;
-	xLastWakeTime = xTaskGetTickCount();
-	const TickType_t frameratePeriod = 20;
+    char line[SAFE_PRINT_MAX_MSG_LEN];
+    uint32_t frame = 0, drawn = 0;
+    uint64_t wait_us;
+    BaseType_t ready;
 
 	tumDrawBindThread(); // Setup Rendering handle with correct GL context
 
+    vFramePacerInit(&frame_pacer, frame_rate, vGameClockHostMicros());
+
 	while (1) {
-		xSemaphoreTake(ScreenLock, portMAX_DELAY);
-		tumDrawUpdateScreen();
+        frame += ulFramePacerBegin(&frame_pacer, vGameClockHostMicros()) + 1;
+        xTaskNotify(GameLoop, frame, eSetValueWithOverwrite);
+        do {
+            ready = xTaskNotifyWait(0, 0, &drawn,
+                        pdMS_TO_TICKS(FRAME_LATE_LIMIT
+                                      * frame_pacer.period_us / 1000));
+        } while (ready == pdTRUE && drawn != frame);
+
+        if (ready == pdTRUE
+                && __atomic_load_n(&held_frame, __ATOMIC_ACQUIRE) == frame) {
+            vFramePacerHeld(&frame_pacer);
+        } else if (ready == pdTRUE && !tumDrawUpdateScreen()) {
+            uint64_t now_us = vGameClockHostMicros();
+
+            vLatencyPresented(now_us);
+            vFramePacerPresented(&frame_pacer, now_us);
+        } else {
+            vFramePacerMissed(&frame_pacer);
+        }
+
+        //the scheduler is running, so only a safe print may write
+        if (__atomic_exchange_n(&frame_times_wanted, 0, __ATOMIC_ACQUIRE)) {
+            vFramePacerSummary(&frame_pacer, line, sizeof(line));
+            prints("%s\n", line);
+        }
+
 		tumEventFetchEvents(FETCH_EVENT_BLOCK);
-		xSemaphoreGive(DrawSignal);
-		xSemaphoreGive(ScreenLock);
-		vTaskDelayUntil(&xLastWakeTime, pdMS_TO_TICKS(frameratePeriod));
+
+        wait_us = ulFramePacerUntilNext(&frame_pacer, vGameClockHostMicros());
+        if (wait_us)
+            vTaskDelay(pdMS_TO_TICKS((wait_us + 999) / 1000));
 	}
 }
 
-int vCheckButtonInput(int key)
+/**
+ * @brief Takes the frame the swap task asked for since the last
+ * call, if any. Frames asked for in between are counted as skipped.
+ * 
+ * @return Number of the frame to draw, or 0 if none is wanted.
+ */
+static uint32_t ulTakeFrameRequest(void)
+{
+    static uint32_t last_frame = 0;
+    uint32_t frame;
+
+    if (xTaskNotifyWait(0, 0, &frame, 0) != pdTRUE)
+        return 0;
+
+    if (last_frame && frame - last_frame > 1)
+        frames_skipped += frame - last_frame - 1;
+    last_frame = frame;
+
+    return frame;
+}
+
+/**
+ * @brief Hands a complete frame to the swap task. The frame is
+ * submitted before the swap task hears of it, and the next one is
+ * recorded into another list while this one is presented.
+ * 
+ * @param frame Number the frame was asked for with.
+ */
+static void vFrameDrawn(uint32_t frame)
+{
+    tumDrawSubmitFrame();
+    xTaskNotify(BufferSwap, frame, eSetValueWithOverwrite);
+}
+
+/**
+ * @brief Tells the swap task that the screen is deliberately left as
+ * it was for a frame, so it is not counted as missed.
+ * 
+ * @param frame Number the frame was asked for with.
+ */
+static void vFrameHeld(uint32_t frame)
+{
+    __atomic_store_n(&held_frame, frame, __ATOMIC_RELEASE);
+    xTaskNotify(BufferSwap, frame, eSetValueWithOverwrite);
+}
+
+void vGetGameInput(input_t *input)
 {
+    input->move = STOP;
+    input->shoot = tumEventGetMouseLeft();
+    input->mothership_direction = vGetOpponentDirection();
+
 	if (xSemaphoreTake(buttons.lock, 0) == pdTRUE) {
-		if (buttons.buttons[key]) {
-			xSemaphoreGive(buttons.lock);
-			switch (key) {
-				case KEYCODE(A):
-                    vMoveSpaceship(RIGHT_TO_LEFT);
-					break;
-				case KEYCODE(D):
-                    vMoveSpaceship(LEFT_TO_RIGHT);
-					break;
-				default:
-					 break;
-			}
-			return 0;
-		}
+		if (buttons.buttons[KEYCODE(A)])
+            input->move += RIGHT_TO_LEFT;
+		if (buttons.buttons[KEYCODE(D)])
+            input->move += LEFT_TO_RIGHT;
 		xSemaphoreGive(buttons.lock);
 	}
-	return 0;
 }
 
 #define UPPER_TEXT_YLOCATION 10
 #define LOWER_TEXT_YLOCATION SCREEN_HEIGHT - DEFAULT_FONT_SIZE - 20
 
-void vDrawScores(void)
+void vDrawScores(int score1, int highscore, int score2, int n_players)
 {
     vDrawText("SCORE<1>", 10, UPPER_TEXT_YLOCATION, NOT_CENTERING);
-    vDrawNumber(my_player.score1, 45, UPPER_TEXT_YLOCATION + DEFAULT_FONT_SIZE * 1.3, 4);
+    vDrawNumber(score1, 45, UPPER_TEXT_YLOCATION + DEFAULT_FONT_SIZE * 1.3, 4);
     vDrawText("HI-SCORE", SCREEN_WIDTH / 3 + 10, UPPER_TEXT_YLOCATION, NOT_CENTERING);
-    vDrawNumber(my_player.highscore, SCREEN_WIDTH / 3 + 25, UPPER_TEXT_YLOCATION + DEFAULT_FONT_SIZE * 1.3, 4);
+    vDrawNumber(highscore, SCREEN_WIDTH / 3 + 25, UPPER_TEXT_YLOCATION + DEFAULT_FONT_SIZE * 1.3, 4);
     vDrawText("SCORE<2>", SCREEN_WIDTH * 2 / 3 + 10, UPPER_TEXT_YLOCATION, NOT_CENTERING);
-    if (my_player.n_players == 2) {
-        vDrawNumber(my_player.score2, SCREEN_WIDTH * 2 / 3 + 25, UPPER_TEXT_YLOCATION + DEFAULT_FONT_SIZE * 1.3, 4);
+    if (n_players == 2) {
+        vDrawNumber(score2, SCREEN_WIDTH * 2 / 3 + 25, UPPER_TEXT_YLOCATION + DEFAULT_FONT_SIZE * 1.3, 4);
     }
 }
 
-void vDrawCredit(void)
+void vDrawCredit(int credits)
 {
     vDrawText("CREDIT", SCREEN_WIDTH * 2 / 3 - 20, LOWER_TEXT_YLOCATION, NOT_CENTERING);
-    vDrawNumber(my_player.credits, SCREEN_WIDTH - 55, LOWER_TEXT_YLOCATION, 2);
+    vDrawNumber(credits, SCREEN_WIDTH - 55, LOWER_TEXT_YLOCATION, 2);
+}
+
+/**
+ * @brief Skips FAST_FORWARD_MS of game time when N is pressed. The
+ * world and every game timer catch up on the next tick, as if the time
+ * had been played.
+ * 
+ */
+static void vCheckFastForwardInput(void)
+{
+	if (xSemaphoreTake(buttons.lock, 0) == pdTRUE) {
+		if (buttons.buttons[KEYCODE(N)]) {
+			buttons.buttons[KEYCODE(N)] = 0;
+            vGameClockAdvance(&game_clock, FAST_FORWARD_MS * 1000);
+		}
+		xSemaphoreGive(buttons.lock);
+	}
 }
 
 void vCheckGameInput(void)
 {
 	vCheckStateInput();
-	vCheckButtonInput(KEYCODE(A));
-	vCheckButtonInput(KEYCODE(D));
     vCheckPauseInput();
+    vCheckFastForwardInput();
 }
 
 void vDrawFirstScreen(void)
@@ -520,13 +596,14 @@ void vDrawSecondScreen(void)
 
 void vDrawMenuText(void)
 {
-    vDrawScores();
+    vDrawScores(my_player.score1, my_player.highscore, my_player.score2,
+                my_player.n_players);
     if (my_player.credits && my_player.n_players) {
         vDrawSecondScreen();
     } else {
         vDrawFirstScreen();
     }
-    vDrawCredit();
+    vDrawCredit(my_player.credits);
 }
 
 void vSetCheat1(void)
@@ -548,66 +625,65 @@ void vSetCheat1(void)
     return;
 }
 
-void vCheckInputSetScore(void *pvParameters)
+//digits of the starting score typed so far
+static char score_text[10] = "0";
+
+/**
+ * @brief Reads the digits of the starting score while the menu waits
+ * for it, until enter is pressed.
+ * 
+ */
+void vCheckInputSetScore(void)
 {
     int i, digit;
-    char text[10] = {'0'};
-    char digit_in_text;
-    vTaskDelay(100);
+    size_t length;
 
-    while(1) {
-        tumEventFetchEvents(FETCH_EVENT_BLOCK |
-					FETCH_EVENT_NO_GL_CHECK);
-        xGetButtonInput();
-        if (xSemaphoreTake(buttons.lock, 0) == pdTRUE) {
-            for (i = 30; i < 40; i++) {//scans scancodes 0 to 9
-                if (buttons.buttons[i]) {
-                    buttons.buttons[i] = 0;
-                    digit = i - 29;//scancode 30 is equal to number 1 so we remove 29
-                    if (digit == 10)//the scancode for button 0 after
-                        digit = 0;//the number 9 so we have to decrement 10
-                    prints("%d\n", digit);
-                    digit_in_text = digit + '0';//converts int to char
-                    sprintf(text, "%s%c", text, digit_in_text);//concatenates the pressed number
+    if (xSemaphoreTake(buttons.lock, 0) == pdTRUE) {
+        for (i = 30; i < 40; i++) {//scans scancodes 0 to 9
+            if (buttons.buttons[i]) {
+                buttons.buttons[i] = 0;
+                digit = i - 29;//scancode 30 is equal to number 1 so we remove 29
+                if (digit == 10)//the scancode for button 0 after
+                    digit = 0;//the number 9 so we have to decrement 10
+                prints("%d\n", digit);
+                length = strlen(score_text);
+                if (length < sizeof(score_text) - 1) {
+                    score_text[length] = digit + '0';//appends the pressed number
+                    score_text[length + 1] = '\0';
                 }
             }
-            if (buttons.buttons[SDL_SCANCODE_RETURN]) {
-                xSemaphoreTake(my_player.lock, portMAX_DELAY);
-                my_player.score1 = atoi(text);
-                xSemaphoreGive(my_player.lock);
-                xSemaphoreGive(buttons.lock);
-                vTaskResume(MenuDrawer);
-                vTaskSuspend(CheckInputSetScore);
-            }
-            xSemaphoreGive(buttons.lock);
         }
-        vTaskDelay(20);
+        if (buttons.buttons[SDL_SCANCODE_RETURN]) {
+            xSemaphoreTake(my_player.lock, portMAX_DELAY);
+            my_player.score1 = atoi(score_text);
+            xSemaphoreGive(my_player.lock);
+            entering_score = 0;
+            prints("Starting score set\n");
+        }
+        xSemaphoreGive(buttons.lock);
     }
 }
 
 void vSetCheat2(void)
 {
     prints("Input the starting score with keyboard and press enter.\n");
-    vTaskResume(CheckInputSetScore);
-    vTaskSuspend(MenuDrawer);
-    prints("Starting score set\n");
+    strcpy(score_text, "0");
+    entering_score = 1;
 }
 
 void vSetCheat3(void)
 {
-    int monster_delay;
-
-    xQueuePeek(MonsterDelayQueue, &monster_delay, portMAX_DELAY);
-    monster_delay = monster_delay + 5;
+    xSemaphoreTake(saved.lock, portMAX_DELAY);
+    saved.offset = saved.offset + 5;
     //delay cannot be decreased too much or it would
     // become negative by the end of each game
-    if (monster_delay > ORIGINAL_MONSTER_DELAY + 20) {
-        monster_delay = ORIGINAL_MONSTER_DELAY;
+    if (saved.offset > MAX_MONSTER_DELAY_OFFSET) {
+        saved.offset = 0;
         prints("Monster speed reseted.\n");
     } else {
         prints("Monster speed decreased.\n");
     }
-    xQueueOverwrite(MonsterDelayQueue, &monster_delay);
+    xSemaphoreGive(saved.lock);
 }
 
 void vCheckCheatInput(void)
@@ -669,232 +745,101 @@ void vCheckMenuInput(void)
     vCheckPlayerSet();
 }
 
-void vMenuDrawer(void *pvParameters)
+void vMenuTick(void)
 {
-	while (1) {
-		xSemaphoreTake(DrawSignal, portMAX_DELAY);
-		tumEventFetchEvents(FETCH_EVENT_BLOCK |
-					FETCH_EVENT_NO_GL_CHECK);
-		xGetButtonInput();// Update global input
+    uint32_t frame;
 
-		xSemaphoreTake(ScreenLock, portMAX_DELAY);
+    frame = ulTakeFrameRequest();
+
+    //the screen is left as it was while the score is typed
+    if (entering_score) {
+        if (frame)
+            vFrameHeld(frame);
+        vCheckInputSetScore();
+        return;
+    }
+
+    //drawn once for every frame the screen shows
+    if (frame) {
 		// Clear screen
 		checkDraw(tumDrawClear(BACKGROUND_COLOUR),
 				__FUNCTION__);
 		vDrawMenuText();
-		xSemaphoreGive(ScreenLock);
-
-        vCheckMenuInput();
-        vUpdateSavedValues();
-	}
-}
-
-int vCheckBulletHitCeiling(bullet_t my_bullet)
-{
-    //bullet exceeded top limit
-    if (my_bullet.y <= TOP_LINE_Y && my_bullet.type == SPACESHIP_BULLET)
-        return 1;
-
-    return 0;
-}
-
-int vCheckBulletHitMonster(bullet_t my_bullet, int i, int j)
-{
-    if (my_bullet.y - BULLET_HEIGHT >= my_monsters.monster[i][j].y
-                && my_bullet.y <= my_monsters.monster[i][j].y
-                                 + my_monsters.monster[i][j].height
-                && my_bullet.x >= my_monsters.monster[i][j].x
-                && my_bullet.x <= my_monsters.monster[i][j].x
-                                 + my_monsters.monster[i][j].width
-                && my_monsters.monster[i][j].alive
-                && my_bullet.type == SPACESHIP_BULLET) {
-        return 1;
-    }
-    return 0;
-}
-
-int vCheckBulletHitFloor(bullet_t my_bullet)
-{
-    if (my_bullet.y + BULLET_HEIGHT >= GREEN_LINE_Y 
-                        && (my_bullet.type == MONSTER_BULLET 
-                        || my_bullet.type == MOTHERSHIP_BULLET)) {
-        return 1;
-    }
-    return 0;
-}
-
-int vCheckBulletHitSpaceship(bullet_t my_bullet)
-{
-    if (my_bullet.y + BULLET_HEIGHT >= my_spaceship.y
-                            && my_bullet.y <= my_spaceship.y + my_spaceship.height
-                            && my_bullet.x >= my_spaceship.x
-                            && my_bullet.x <= my_spaceship.x + my_spaceship.width
-                            && (my_bullet.type == MONSTER_BULLET
-                            || my_bullet.type == MOTHERSHIP_BULLET)) {
-        return 1;
-    }
-    return 0;
-}
-
-int vCheckBulletHitMothership(bullet_t my_bullet)
-{
-    if (my_bullet.y - BULLET_HEIGHT >= my_mothership.y
-                            && my_bullet.y <= my_mothership.y + my_mothership.height
-                            && my_bullet.x >= my_mothership.x
-                            && my_bullet.x <= my_mothership.x + my_mothership.width
-                            && my_mothership.alive 
-                            && my_bullet.type == SPACESHIP_BULLET) {
-            return 1;
-    }
-    return 0;
-}
-
-int vCheckBulletHitBunker(bullet_t my_bullet, int a, int i, int j)
-{
-    if (my_bunkers.bunker[a].component[i][j].damage < 3
-                    && (my_bullet.y - BULLET_HEIGHT >= my_bunkers.bunker[a].component[i][j].y)
-                    && my_bullet.y <= my_bunkers.bunker[a].component[i][j].y 
-                    + my_bunkers.bunker[a].component[i][j].height
-                    && my_bullet.x >= my_bunkers.bunker[a].component[i][j].x
-                    && my_bullet.x <= my_bunkers.bunker[a].component[i][j].x 
-                    + my_bunkers.bunker[a].component[i][j].width) {
-        return 1;
-    }
-    return 0;
-}
-
-void vCheckBulletColision(void)
-{
-    int k = 0, i, j, a, n_bullets;
-    bullet_t my_bullet[MAX_OBJECTS];
-
-    while (uxQueueMessagesWaiting(BulletQueue)) {
-        xQueueReceive(BulletQueue, &my_bullet[k], portMAX_DELAY);
-
-        if (vCheckBulletHitCeiling(my_bullet[k])) {//bullet exceeded top limit
-            createColision(my_bullet[k].x, my_bullet[k].y, colision_image[0]);
-            goto colision_detected;
-        }
-
-        for (i = 0; i < N_ROWS; i++) {
-            for (j = 0; j < N_COLUMNS; j++) {
-                if (vCheckBulletHitMonster(my_bullet[k], i, j)) {
-                    vUpdatePlayerScore(i, j);
-                    createColision(my_monsters.monster[i][j].x 
-                                     + my_monsters.monster[i][j].width / 2, 
-                                    my_monsters.monster[i][j].y
-                                     + my_monsters.monster[i][j].height / 2,
-                                                     colision_image[1]);
-                    vKillMonster(i, j);
-                    tumSoundPlayUserSample("invaderkilled.wav");
-                    vDecreaseMonsterDelay();
-                    goto colision_detected;
-                }
-            }
-        }
-
-        if (vCheckBulletHitFloor(my_bullet[k])) {
-            createColision(my_bullet[k].x, my_bullet[k].y + BULLET_HEIGHT,
-                             colision_image[0]);
-            goto colision_detected;
-        }
-
-        if (vCheckBulletHitSpaceship(my_bullet[k])) {
-            vPlayerGetHit();
-            if (my_bullet[k].type == MOTHERSHIP_BULLET) {
-                vUpdateAIScore();
-            }
-            createColision(my_spaceship.x + my_spaceship.width / 2,
-                     my_spaceship.y + my_spaceship.height / 2, colision_image[1]);
-            tumSoundPlayUserSample("explosion.wav");
-            vResetSpaceship();
-            goto colision_detected;
-        }
-
-        if (vCheckBulletHitMothership(my_bullet[k])) {
-            vUpdatePlayerScoreRandom();
-            createColision(my_mothership.x + my_mothership.width / 2, 
-                    my_mothership.y + my_mothership.height / 2, colision_image[1]);
-            if (my_player.n_players == 1) {
-                vResetMothership();
-                vKillMothership();
-            }
-            goto colision_detected;
-        }
-
-        for (a = 0; a < N_BUNKERS; a++) {
-            for (i = 0; i < 2; i++) {
-                for (j = 0; j < 3; j++) {
-                    if (vCheckBulletHitBunker(my_bullet[k], a, i, j)) {
-                        vBunkerGetHit(a, i, j);
-                        createColision(my_bullet[k].x, my_bullet[k].y, NULL);
-                        goto colision_detected;
-                    }
-                }
-            }
-        }
-
-        k++;// does not get here if bullet gets killed
-        continue;
-
-    colision_detected:
-        continue;
+        vFrameDrawn(frame);
     }
 
-    n_bullets = k;
-    for (k = 0; k < n_bullets; k++) {
-        xQueueSend(BulletQueue, &my_bullet[k], portMAX_DELAY);
-    }
+    vCheckMenuInput();
+    vUpdateSavedValues();
 }
 
-void vResetGame(void)
+/**
+ * @brief Expires the effects that have run their course, spawns
+ * one for every event of the last step and plays every sound
+ * cued by the world once.
+ * 
+ */
+void vPlayWorldEffects(const world_t *world)
 {
-    vTaskSuspend(GameDrawer);
-    vTaskSuspend(EnemyBulletShooter);
-    vTaskDelay(pdMS_TO_TICKS(1000));
-    vResetGameBoard();
-    vTaskResume(GameDrawer);
-    vTaskResume(EnemyBulletShooter);
-}
+    int k;
+    const game_event_t *event;
 
-void vCheckMonstersDead(void)
-{
-    int i, j, n_monster_alive = 0;
+    vExpireEffects(world->tick);
 
-    for (i = 0; i < N_ROWS; i++) {
-        for (j = 0; j < N_COLUMNS; j++) {
-            if (my_monsters.monster[i][j].alive)
-                n_monster_alive++;
+    for (k = 0; k < world->n_shown; k++) {
+        event = &world->shown[k];
+        switch (event->type) {
+            case EVENT_MONSTER_KILLED:
+            case EVENT_PLAYER_HIT:
+            case EVENT_MOTHERSHIP_HIT:
+                vSpawnEffect(EFFECT_EXPLOSION, event->x, event->y,
+                             world->tick);
+                break;
+            case EVENT_BULLET_SPENT:
+                vSpawnEffect(EFFECT_IMPACT, event->x, event->y,
+                             world->tick);
+                break;
+            default:
+                break;
         }
     }
 
-    if (!n_monster_alive) {
-        vResetGame();
-    }
+    if (world->cues & WORLD_CUE_SHOOT)
+        tumSoundPlayUserSample("shoot.wav");
+    if (world->cues & WORLD_CUE_MARCH)
+        vPlayMonsterSound();
+    if (world->cues & WORLD_CUE_MOTHERSHIP)
+        tumSoundPlayUserSample("ufo_highpitch.wav");
+    if (world->cues & WORLD_CUE_MONSTER_KILLED)
+        tumSoundPlayUserSample("invaderkilled.wav");
+    if (world->cues & WORLD_CUE_EXPLOSION)
+        tumSoundPlayUserSample("explosion.wav");
 }
 
-int vCheckMonstersInvaded(void)
+/**
+ * @brief Once the wave is cleared or the player died, freezes
+ * the screen for a second and sets up the board again.
+ * A dead player also gets the values it started with back.
+ * 
+ */
+void vCheckWorldStatus(void)
 {
-    int i, j;
-
-    for (i = N_ROWS - 1; i >= 0; i--) {
-        for (j = 0; j < N_COLUMNS; j++) {
-            if (my_monsters.monster[i][j].alive
-             && my_monsters.monster[i][j].y + my_monsters.monster[i][j].height
-              >= my_bunkers.bunker[1].component[0][0].y) {
-                  return 1;
-              }
-        }
-    }
-    return 0;
-}
+    if (my_world.status == WORLD_PLAYING)
+        return;
 
-void vCheckPlayerDead(void)
-{
-    if (!my_player.n_lives || vCheckMonstersInvaded()) {
+    //nothing is drawn while the game loop waits
+    vPauseGameClock();
+    vTaskDelay(pdMS_TO_TICKS(1000));
+    vResumeGameClock();
+    vResetEffects();
+    if (my_world.status == WORLD_PLAYER_DEAD) {
         vResetPlayer();
-        vResetGame();
+        vStartMatch(my_world.n_players);
+    } else {
+        wave_index++;
+        vReplayResetBoard(&replay, xGetWave(wave_index), saved.offset);
+        world_reset_board(&my_world, xGetWave(wave_index), saved.offset);
     }
+    vPublishWorldSnapshot(&my_world);
 }
 
 void vCheckMothershipDifficultyChange(void)
@@ -916,14 +861,16 @@ void vCheckMothershipDifficultyChange(void)
 	}
 }
 
-void vCheckSendSpaceshipMothershipDiff(void)
+void vCheckSendSpaceshipMothershipDiff(const world_snapshot_t *world)
 {
-    static TickType_t lastTimeSend = 0;
+    static game_timer_t send_timer = { 0 };
+    uint64_t now = xGetGameTime();
 
-    if (xTaskGetTickCount() - lastTimeSend > pdMS_TO_TICKS(500)) {
-        vSendSpaceshipMothershipDiff();
-        lastTimeSend = xTaskGetTickCount();
-    }
+    if (!send_timer.armed)
+        vGameTimerStart(&send_timer, now, 0, 500 * 1000);
+
+    if (vGameTimerExpired(&send_timer, now))
+        vSendSpaceshipMothershipDiff(world);
 }
 
 void vCheckSendBulletState(char *bullet_state)
@@ -939,169 +886,98 @@ void vCheckSendBulletState(char *bullet_state)
     }
 }
 
-void vCheckBulletShoot(char *bullet_state)
+void vDrawGameText(const world_snapshot_t *world)
 {
-    if (tumEventGetMouseLeft() && strcmp(bullet_state, "PASSIVE") == 0) {
-        vShootBullet(my_spaceship.x + my_spaceship.width / 2,
-                     my_spaceship.y, SPACESHIP_BULLET);
-        tumSoundPlayUserSample("shoot.wav");
-    }
+    vDrawScores(world->score1, world->highscore, world->score2,
+                world->n_players);
+    vDrawCredit(world->credits);
+    vDrawNumber(world->n_lives, 20, LOWER_TEXT_YLOCATION, 1);
 }
 
-void vGameLogic(void *pvParameters)
+void vDrawLives(const world_snapshot_t *world)
 {
-    char bullet_state[12] = "PASSIVE";
-
-	while (1) {
-        xGetButtonInput();
-
-        vUpdateBulletPosition();
-        if (my_player.n_players == 1)
-            vUpdateMothershipPosition();
-        else
-            vUpdateMothershipPositionPVP();
-
-        vCheckBulletColision();
-
-        vSpaceshipBulletActive(bullet_state);
-        vCheckBulletShoot(bullet_state);
-
-        if (my_player.n_players == 2) {
-            vCheckSendSpaceshipMothershipDiff();
-            vCheckSendBulletState(bullet_state);
-            vCheckMothershipDifficultyChange();
-        }
-
-        vCheckMonstersDead();
-        vCheckPlayerDead();
-        vCheckGameInput();
-
-        vTaskDelay(pdMS_TO_TICKS(8));
-	}
-}
-
-void vDrawGameText(void)
-{
-    vDrawScores();
-    vDrawCredit();
-    vDrawNumber(my_player.n_lives, 20, LOWER_TEXT_YLOCATION, 1);
-}
-
-void vDrawLives(void)
-{
-    if (my_player.n_lives >= 2)
-        checkDraw(tumDrawLoadedImage(my_spaceship.image, 55,
+    if (world->n_lives >= 2)
+        checkDraw(tumDrawLoadedImage(spaceship_image, 55,
                          LOWER_TEXT_YLOCATION + 5), __FUNCTION__);
-    if (my_player.n_lives >= 3)
-        checkDraw(tumDrawLoadedImage(my_spaceship.image,
-                        55 + my_spaceship.width * 1.2, LOWER_TEXT_YLOCATION + 5),
+    if (world->n_lives >= 3)
+        checkDraw(tumDrawLoadedImage(spaceship_image,
+                        55 + world_config.spaceship_width * 1.2, LOWER_TEXT_YLOCATION + 5),
                      __FUNCTION__);
 }
 
-void vDrawGameObjects(void)
+void vDrawGameObjects(const world_snapshot_t *world)
 {
-    vDrawSpaceship();
-    vDrawMonsters();
-    vDrawBunkers();
-    vDrawMothership();
-    vDrawBullets();
-    vDrawColisions();
+    vDrawSpaceship(world);
+    vDrawMonsters(world);
+    vDrawBunkers(world);
+    vDrawMothership(world);
+    vDrawBullets(world);
+    vDrawEffects(world);
 
     //draws line separating game and bottom of screen
-    checkDraw(tumDrawFilledBox(0, GREEN_LINE_Y, SCREEN_WIDTH, 0, Green), __FUNCTION__);
-
-    vDrawLives();
-}
-
-void vGameDrawer(void *pvParameters)
-{
-	while (1) {
-		xSemaphoreTake(DrawSignal, portMAX_DELAY);
-        tumEventFetchEvents(FETCH_EVENT_BLOCK |
-				    FETCH_EVENT_NO_GL_CHECK);
-		xSemaphoreTake(ScreenLock, portMAX_DELAY);
-		checkDraw(tumDrawClear(BACKGROUND_COLOUR), __FUNCTION__);
-		vDrawGameText();
-        vDrawGameObjects();
-		xSemaphoreGive(ScreenLock);
-	}
-}
-
-void vShootMothershipBullet(void)
-{
-    if (my_player.n_players == 2)
-        vShootBullet(my_mothership.x + my_mothership.width / 2,
-                    my_mothership.y + my_mothership.height, MOTHERSHIP_BULLET);
-}
-
-int vChooseShooterColumn(void)
-{
-    return rand() % N_COLUMNS;
-}
-
-int vChooseShooterRow(int shooter_column)
-{
-    int i;
+    checkDraw(tumDrawFilledBox(0, GREEN_LINE_Y(SCREEN_HEIGHT), SCREEN_WIDTH, 0, Green), __FUNCTION__);
 
-    for (i = N_ROWS - 1; i >= 0; i--) {
-        if (my_monsters.monster[i][shooter_column].alive) {
-            return i;
-        }
-    }
-
-    return -1;
+    vDrawLives(world);
 }
 
 /**
- * @brief Chooses a random column of enemies
- * Of the choosen column scans through the monster bottom
- * to top and finds the first monster alive.
- * If no monster is alive returns repeats the process
- * until a column with a alive monster is found.
+ * @brief Draws the latest complete tick, once for every frame the
+ * screen shows.
  * 
- * @param pvParameters 
  */
-void vEnemyBulletShooter(void *pvParameters) {
-    int shooter_column, shooter_row;
-
-    while (1) {
-        shooter_column = vChooseShooterColumn();
-        
-        shooter_row = vChooseShooterRow(shooter_column);
-        if (shooter_row == -1)
-            continue;
-
-        vShootBullet(my_monsters.monster[shooter_row][shooter_column].x 
-                     + my_monsters.monster[shooter_row][shooter_column].width / 2,
-                     my_monsters.monster[shooter_row][shooter_column].y 
-                     + my_monsters.monster[shooter_row][shooter_column].height,
-                         MONSTER_BULLET);
-
-        vShootMothershipBullet();
-
-        vTaskDelay(pdMS_TO_TICKS(2500));
-    }
-}
-
-void vMonsterMover(void *pvParameters)
+void vDrawGame(void)
 {
-    int i, j, direction = LEFT_TO_RIGHT;
+    const world_snapshot_t *world;
+    uint32_t frame = ulTakeFrameRequest();
 
-    TickType_t monster_delay;
+    if (!frame)
+        return;
 
-    while (1) {
-        for (i = N_ROWS - 1 ; i >= 0; i--) {
-            for (j = 0; j < N_COLUMNS; j++) {
-                if (!vMoveMonster(i, j, direction)) {
-                    continue;
-                }
-                xQueuePeek(MonsterDelayQueue, &monster_delay, portMAX_DELAY);
-                vTaskDelay(pdMS_TO_TICKS(monster_delay));
-            }
-            vMonsterCallback();//Plays the monsters moving sound
-        }
-        vUpdateMonsterDirection(&direction);//only if any monster hits wall
+    world = vAcquireWorldSnapshot();
+	checkDraw(tumDrawClear(BACKGROUND_COLOUR), __FUNCTION__);
+	vDrawGameText(world);
+    vDrawGameObjects(world);
+    vLatencyFrameDrawn(world->input_seq);
+    vFrameDrawn(frame);
+}
+
+void vGameTick(void)
+{
+    static char bullet_state[12] = "PASSIVE";
+    const world_snapshot_t *snapshot;
+    uint64_t now_ms;
+    uint64_t input_stamps[INPUT_STAMPS_MAX];
+    int n_stamps;
+    input_t input;
+
+    n_stamps = tumEventTakeInputStamps(input_stamps, INPUT_STAMPS_MAX);
+    vGetGameInput(&input);
+    vLatencyInputConsumed(input_stamps, n_stamps, vGameClockHostMicros());
+
+    //the game clock stands still outside of the game, so a long
+    //step only ever means the clock was sped up
+    now_ms = xGetGameTime() / 1000;
+    vReplayStep(&replay, &input, now_ms - last_step_ms);
+    world_step(&my_world, &input, now_ms - last_step_ms);
+    last_step_ms = now_ms;
+    vUpdatePlayerFromWorld(&my_world);
+    vPlayWorldEffects(&my_world);
+
+    snapshot = vPublishWorldSnapshot(&my_world);
+
+    if (snapshot->n_players == 2) {
+        if (world_spaceship_bullet_active(&my_world))
+            strcpy(bullet_state, "ATTACKING");
+        else
+            strcpy(bullet_state, "PASSIVE");
+        vCheckSendSpaceshipMothershipDiff(snapshot);
+        vCheckSendBulletState(bullet_state);
+        vCheckMothershipDifficultyChange();
     }
+
+    vCheckWorldStatus();
+    vDrawGame();
+    vCheckGameInput();
 }
 
 void vDrawPauseText(void)
@@ -1119,18 +995,51 @@ void vDrawPauseText(void)
     }
 }
 
-void vPauseDrawer(void *pvParameters)
+void vPauseTick(void)
 {
-	while (1) {
-		xSemaphoreTake(DrawSignal, portMAX_DELAY);
-        tumEventFetchEvents(FETCH_EVENT_BLOCK |
-				    FETCH_EVENT_NO_GL_CHECK);
-        xGetButtonInput();
-		xSemaphoreTake(ScreenLock, portMAX_DELAY);
+    uint32_t frame = ulTakeFrameRequest();
+
+    if (frame) {
 		checkDraw(tumDrawClear(BACKGROUND_COLOUR), __FUNCTION__);
         vDrawPauseText();
-		xSemaphoreGive(ScreenLock);
-        vCheckPauseInput();
+        vFrameDrawn(frame);
+    }
+    vCheckPauseInput();
+}
+
+/**
+ * @brief Runs the whole game: every tick the current state is
+ * handled by a plain call, then the state asked for, if any, is
+ * entered. Only the buffer swap runs besides it.
+ * 
+ */
+void vGameLoop(void *pvParameters)
+{
+    vMailboxWrite(CurrentStateMailbox, &current_state);
+    vSwitchToMenu(current_state);
+
+	while (1) {
+        tumEventFetchEvents(FETCH_EVENT_BLOCK | FETCH_EVENT_NO_GL_CHECK);
+        xGetButtonInput();
+        vCheckFrameTimesInput();
+
+        switch (current_state) {
+            case MENU:
+                vMenuTick();
+                break;
+            case GAME:
+                vGameTick();
+                break;
+            case PAUSE:
+                vPauseTick();
+                break;
+            default:
+                break;
+        }
+
+        vCheckStateChange();
+
+        vTaskDelay(pdMS_TO_TICKS(WORLD_TICK_MS));
 	}
 }
 
@@ -1140,15 +1049,9 @@ void vInitImages(void)
     monster_image[0] = tumDrawLoadImage("monster_spritesheet1.png");
     monster_image[1] = tumDrawLoadImage("monster_spritesheet2.png");
     monster_image[2] = tumDrawLoadImage("monster_spritesheet3.png");
-    colision_image[0] = tumDrawLoadImage("colision1.png");
-    colision_image[1] = tumDrawLoadImage("colision2.png");
+    effect_image[EFFECT_IMPACT] = tumDrawLoadImage("colision1.png");
+    effect_image[EFFECT_EXPLOSION] = tumDrawLoadImage("colision2.png");
     mothership_image = tumDrawLoadImage("mothership.png");
-    bunker_image[0] = tumDrawLoadImage("bunker1.png");
-    bunker_image[1] = tumDrawLoadImage("bunker2.png");
-    bunker_image[2] = tumDrawLoadImage("bunker3.png");
-    bunker_image[3] = tumDrawLoadImage("bunker4.png");
-    bunker_image[4] = tumDrawLoadImage("bunker5.png");
-    bunker_image[5] = tumDrawLoadImage("bunker6.png");
 }
 
 void vInitSpriteSheets(void)
@@ -1176,6 +1079,102 @@ void vSaveHighScore(void)
     fclose(fp);
 }
 
+//host time the scheduler was started at
+static uint64_t session_start_us;
+
+/**
+ * @brief Prints how often the port switched threads during the
+ * session, which is where most of the time of the simulator goes.
+ * 
+ */
+void vReportContextSwitches(void)
+{
+    unsigned long n = ulPortGetContextSwitchCount();
+    double seconds = (vGameClockHostMicros() - session_start_us) / 1e6;
+
+    if (seconds > 0)
+        printf("%lu context switches, %.0f per second\n", n, n / seconds);
+}
+
+void vReportFrames(void)
+{
+    char line[SAFE_PRINT_MAX_MSG_LEN];
+
+    vFramePacerSummary(&frame_pacer, line, sizeof(line));
+    printf("%lu frames skipped by the game loop\n", frames_skipped);
+    printf("%s\n", line);
+}
+
+void vSaveFrameTimes(void)
+{
+    FILE *fp = NULL;
+
+    fp = fopen("frames.csv", "w");
+    if (!fp)
+        return;
+    vFramePacerDump(&frame_pacer, fp);
+    fclose(fp);
+}
+
+static const char *state_names[STATE_COUNT] = { "menu", "game", "pause" };
+
+static FILE *run_stats_file = NULL;
+
+/**
+ * @brief Writes how the tasks shared the CPU to run_stats.csv once
+ * every RUN_STATS_PERIOD_MS, and right away when the state changes so
+ * that every sample belongs to one state. RUN_STATS_SIGNAL writes a
+ * sample and prints the run time of every task.
+ * 
+ */
+void vRunStatsReporter(void *pvParameters)
+{
+    TickType_t last_sample = xTaskGetTickCount();
+    unsigned char state = STARTING_STATE, sampled_state = STARTING_STATE;
+    int requested;
+
+    vRunStatsInit();
+
+	while (1) {
+        vTaskDelay(pdMS_TO_TICKS(RUN_STATS_POLL_MS));
+
+        ulMailboxRead(CurrentStateMailbox, &state);
+        requested = xRunStatsRequested();
+        if (requested || state != sampled_state
+                || xTaskGetTickCount() - last_sample
+                   >= pdMS_TO_TICKS(RUN_STATS_PERIOD_MS)) {
+            vRunStatsSample(run_stats_file, state_names[sampled_state]);
+            fflush(run_stats_file);
+            last_sample = xTaskGetTickCount();
+            sampled_state = state;
+        }
+        if (requested)
+            vRunStatsPrint();
+	}
+}
+
+void vCloseRunStats(void)
+{
+    if (run_stats_file)
+        fclose(run_stats_file);
+}
+
+void vCloseReplay(void)
+{
+    vReplayClose(&replay);
+}
+
+void vSaveLatency(void)
+{
+    FILE *fp = NULL;
+
+    fp = fopen("latency.csv", "w");
+    if (!fp)
+        return;
+    vLatencyDump(fp);
+    fclose(fp);
+}
+
 /**
  * @brief Data can still be received even if player selects 1 player mode or is in menu
  * If thats the case, then doesn't do anything with the received data
@@ -1184,12 +1183,11 @@ void vSaveHighScore(void)
  */
 int vCheckCanReceiveData(void)
 {
-    int current_state;
+    unsigned char current_state;
 
-    if (xQueuePeek(CurrentStateQueue, &current_state, 0) == pdTRUE) {
-        if (current_state == GAME && my_player.n_players == 2) {
-            return 1;
-        }
+    ulMailboxRead(CurrentStateMailbox, &current_state);
+    if (current_state == GAME && my_player.n_players == 2) {
+        return 1;
     }
 
     return 0;
@@ -1197,9 +1195,50 @@ int vCheckCanReceiveData(void)
 
 #define PRINT_TASK_ERROR(task) PRINT_ERROR("Failed to print task ##task");
 
+static void vUsage(const char *name)
+{
+    fprintf(stderr, "usage: %s [-s clock scale] [-r replay to record] "
+            "[-f frames per second]\n", name);
+}
+
 int main(int argc, char *argv[])
 {
 	char *bin_folder_path = tumUtilGetBinFolderPath(argv[0]);
+    //soak tests run the game clock faster than real time
+    double clock_scale = 1;
+    //the session is recorded to be played back by SpaceInvadersSim -p
+    const char *replay_path = NULL;
+    replay_header_t replay_header;
+    char *end;
+    long rate;
+    int opt;
+
+    while ((opt = getopt(argc, argv, "s:r:f:")) != -1) {
+        switch (opt) {
+            case 's':
+                clock_scale = strtod(optarg, &end);
+                //the clock keeps the scale in thousandths
+                if (*end || !(clock_scale * GAME_CLOCK_SCALE_ONE >= 1)
+                        || clock_scale > 1000)
+                    goto err_usage;
+                break;
+            case 'r':
+                replay_path = optarg;
+                break;
+            case 'f':
+                //frames per second the screen is paced to
+                rate = strtol(optarg, &end, 10);
+                if (*end || rate < 1 || rate > 1000)
+                    goto err_usage;
+                frame_rate = rate;
+                break;
+            default:
+                goto err_usage;
+        }
+    }
+    if (optind < argc) {
+        goto err_usage;
+    }
 
 	prints("Initializing: ");
 
@@ -1243,75 +1282,14 @@ int main(int argc, char *argv[])
 		goto err_buttons_lock;
 	}
 
-	DrawSignal = xSemaphoreCreateBinary(); // Screen buffer locking
-	if (!DrawSignal) {
-		PRINT_ERROR("Failed to create draw signal");
-		goto err_draw_signal;
-	}
-	ScreenLock = xSemaphoreCreateMutex();
-	if (!ScreenLock) {
-		PRINT_ERROR("Failed to create screen lock");
-		goto err_screen_lock;
-	}
-
-	//Queues
-	StateChangeQueue =
-		xQueueCreate(UNITARY_QUEUE_LENGHT, sizeof(unsigned char));
-	if (!StateChangeQueue) {
-		PRINT_ERROR("Could not open state change queue");
-		goto err_state_change_queue;
-	}
-
-	CurrentStateQueue =
-		xQueueCreate(UNITARY_QUEUE_LENGHT, sizeof(unsigned char));
-	if (!CurrentStateQueue) {
-		PRINT_ERROR("Could not open current state queue");
-		goto err_current_state_queue;
+	//Mailboxes
+	CurrentStateMailbox = xMailboxCreate(sizeof(unsigned char));
+	if (!CurrentStateMailbox) {
+		PRINT_ERROR("Could not open current state mailbox");
+		goto err_current_state_mailbox;
 	}
 
-    BulletQueue =
-		xQueueCreate(MAX_OBJECTS, sizeof(bullet_t));
-	if (!BulletQueue) {
-		PRINT_ERROR("Could not open bullet queue");
-		goto err_bullet_queue;
-	}
-
-    ColisionQueue =
-		xQueueCreate(MAX_OBJECTS, sizeof(colision_t));
-	if (!ColisionQueue) {
-		PRINT_ERROR("Could not open colision queue");
-		goto err_colision_queue;
-	}
-
-    TimerStartingQueue =
-		xQueueCreate(UNITARY_QUEUE_LENGHT, sizeof(TickType_t));
-	if (!TimerStartingQueue) {
-		PRINT_ERROR("Could not open timer value queue");
-		goto err_timer_starting_queue;
-	}
-
-    MonsterDelayQueue =
-		xQueueCreate(UNITARY_QUEUE_LENGHT, sizeof(TickType_t));
-	if (!MonsterDelayQueue) {
-		PRINT_ERROR("Could not open monster delay queue");
-		goto err_monster_delay_queue;
-	}
-
-	//Timers
-    xMothershipTimer = xTimerCreate("Mothership Timer", pdMS_TO_TICKS(ORIGINAL_TIMER),
-                                     pdTRUE, (void *) 0, vMothershipTimerCallback);
-    if (xMothershipTimer == NULL) {
-        PRINT_ERROR("Could not open mothership timer");
-        goto err_mothership_timer;
-    }
-
 	//Infrastructure Tasks
-	if (xTaskCreate(basicSequentialStateMachine, "StateMachine",
-			STACK_SIZE, NULL,
-			configMAX_PRIORITIES - 1, &StateMachine) != pdPASS) {
-		PRINT_TASK_ERROR("StateMachine");
-		goto err_statemachine;
-	}
 	if (xTaskCreate(vSwapBuffers, "BufferSwapTask",
 			STACK_SIZE, NULL, configMAX_PRIORITIES,
 			&BufferSwap) != pdPASS) {
@@ -1319,116 +1297,80 @@ int main(int argc, char *argv[])
 		goto err_bufferswap;
 	}
 
-	if (xTaskCreate(vGameLogic, "GameLogic", STACK_SIZE,
-			NULL, mainGENERIC_PRIORITY + 2, &GameLogic) != pdPASS) {
-		PRINT_TASK_ERROR("GameLogic");
-		goto err_game_logic;
-	}
-
-    if (xTaskCreate(vEnemyBulletShooter, "EnemyBulletShooter", STACK_SIZE,
-			NULL, mainGENERIC_PRIORITY + 3, &EnemyBulletShooter) != pdPASS) {
-		PRINT_TASK_ERROR("EnemyBulletShooter");
-		goto err_monster_bullet_shooter;
+	//every state runs in the game loop
+	GameLoop = xTaskCreateStatic(vGameLoop, "GameLoop", STACK_SIZE, NULL,
+				     mainGENERIC_PRIORITY + 2, xStack,
+				     &GameLoopBuffer);
+	if (GameLoop == NULL) {
+		PRINT_TASK_ERROR("GameLoop");
+		goto err_game_loop;
 	}
 
-    if (xTaskCreate(vMonsterMover, "MonsterMover", STACK_SIZE,
-			NULL, mainGENERIC_PRIORITY, &MonsterMover) != pdPASS) {
-		PRINT_TASK_ERROR("MonsterMover");
-		goto err_monster_mover;
-	}
-
-    if (xTaskCreate(vCheckInputSetScore, "CheckInputSetScore", STACK_SIZE,
-			NULL, mainGENERIC_PRIORITY,
-			&CheckInputSetScore) != pdPASS) {
-		PRINT_TASK_ERROR("CheckInputSetScore");
-		goto err_CheckInputSetScore;
-	}
-
-	//State Drawer Tasks
-	if (xTaskCreate(vMenuDrawer, "MenuDrawer", STACK_SIZE,
-			NULL, mainGENERIC_PRIORITY + 1,
-			&MenuDrawer) != pdPASS) {
-		PRINT_TASK_ERROR("MenuDrawer");
-		goto err_MenuDrawer;
-	}
-
-	GameDrawer = xTaskCreateStatic(vGameDrawer, "GameDrawer", STACK_SIZE, NULL,
-				       mainGENERIC_PRIORITY + 1, xStack,
-				       &GameDrawerBuffer);
-	if (GameDrawer == NULL) {
-		PRINT_TASK_ERROR("GameDrawer");
-		goto err_GameDrawer;
-	}
-
-    if (xTaskCreate(vPauseDrawer, "PauseDrawer", STACK_SIZE,
-			NULL, mainGENERIC_PRIORITY + 1,
-			&PauseDrawer) != pdPASS) {
-		PRINT_TASK_ERROR("PauseDrawer");
-		goto err_PauseDrawer;
-	}
-
-    srand(time(NULL));
+    //only runs when nothing else wants the CPU
+    run_stats_file = fopen("run_stats.csv", "w");
+    if (run_stats_file) {
+        vRunStatsHeader(run_stats_file);
+        if (xTaskCreate(vRunStatsReporter, "RunStats", STACK_SIZE, NULL,
+                        mainGENERIC_PRIORITY + 1,
+                        &RunStatsReporter) != pdPASS) {
+            PRINT_TASK_ERROR("RunStats");
+            goto err_run_stats;
+        }
+    } else {
+        prints("Could not create run_stats.csv, no run time stats are kept.\n");
+    }
 
     vInitImages();
     vInitSpriteSheets();
     vInitSounds();
 
+    vInitSprites(spaceship_image, monster_image, monster_spritesheet,
+                 mothership_image, effect_image, &world_config);
+    vGameClockInit(&game_clock, vGameClockHostMicros());
+    vGameClockSetScale(&game_clock, vGameClockHostMicros(),
+                       clock_scale * GAME_CLOCK_SCALE_ONE);
+    world_original_wave(&original_wave, N_ROWS, N_COLUMNS);
+    if (vWavePackOpen(&wave_pack, tumUtilFindResourcePath("waves.bin")))
+        prints("No wave pack found, playing the original wave only.\n");
+    replay_header.seed = time(NULL);
+    replay_header.config = world_config;
+    replay_header.wave = *xGetWave(0);
+    world_init(&my_world, &world_config, xGetWave(0), replay_header.seed);
+    if (replay_path && vReplayCreate(&replay, replay_path, &replay_header))
+        prints("Could not create %s, the session is not recorded.\n",
+               replay_path);
+    vInitWorldSnapshots();
     vInitPlayer();
-    vInitSpaceship(spaceship_image);
-    vInitMonsters(monster_image, monster_spritesheet);
-    vInitMonsterDelay();
-    vInitMothership(mothership_image);
-    vInitBunkers(bunker_image);
     vInitSavedValues();
     vInitPVP();
 
     atexit(vSaveHighScore);
+    atexit(vSaveLatency);
+    atexit(vCloseReplay);
+    atexit(vReportContextSwitches);
+    atexit(vReportFrames);
+    atexit(vSaveFrameTimes);
+    atexit(vCloseRunStats);
     atexit(aIODeinit);
     atexit(vObjectSemaphoreDelete);
 
     printf("Welcome to Space Invaders Remastered HD!\n");
 
-	vSuspendAllTasks();
+    //the menu comes first, the game clock only runs in the game
+	vPauseGameClock();
 
+    session_start_us = vGameClockHostMicros();
 	vTaskStartScheduler();
 
 	return EXIT_SUCCESS;
-	vTaskDelete(PauseDrawer);
-err_PauseDrawer:
-	vTaskDelete(GameDrawer);
-err_GameDrawer:
-	vTaskDelete(MenuDrawer);
-err_MenuDrawer:
-    vTaskDelete(CheckInputSetScore);
-err_CheckInputSetScore:
-    vTaskDelete(MonsterMover);
-err_monster_mover:
-    vTaskDelete(EnemyBulletShooter);
-err_monster_bullet_shooter:
-	vTaskDelete(GameLogic);
-err_game_logic:
+err_run_stats:
+    fclose(run_stats_file);
+	vTaskDelete(GameLoop);
+err_game_loop:
 	vTaskDelete(BufferSwap);
 err_bufferswap:
-	vTaskDelete(StateMachine);
-err_statemachine:
-    xTimerDelete(xMothershipTimer, portMAX_DELAY);
-err_mothership_timer:
-    vQueueDelete(MonsterDelayQueue);
-err_monster_delay_queue:
-    vQueueDelete(TimerStartingQueue);
-err_timer_starting_queue:
-    vQueueDelete(ColisionQueue);
-err_colision_queue:
-    vQueueDelete(BulletQueue);
-err_bullet_queue:
-	vQueueDelete(CurrentStateQueue);
-err_current_state_queue:
-	vQueueDelete(StateChangeQueue);
-err_state_change_queue:
-	vSemaphoreDelete(ScreenLock);
-err_screen_lock:
-	vSemaphoreDelete(DrawSignal);
-err_draw_signal:
+	vMailboxDelete(CurrentStateMailbox);
+err_current_state_mailbox:
 	vSemaphoreDelete(buttons.lock);
 err_buttons_lock:
 	safePrintExit();
@@ -1440,6 +1382,9 @@ err_init_events:
 	tumDrawExit();
 err_init_drawing:
 	return EXIT_FAILURE;
+err_usage:
+    vUsage(argv[0]);
+    return EXIT_FAILURE;
 }
 
 // cppcheck-suppress unusedFunction
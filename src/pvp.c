@@ -24,6 +24,9 @@
 #include "objects.h"
 #include "pvp.h"
 
+//written by the receive callback, read by the game logic
+static volatile int opponent_direction = LEFT_TO_RIGHT;
+
 void vSendBulletState(char *bullet_state_tosend)
 {
     if(aIOSocketPut(UDP, IPv4_addr, UDP_TRANSMIT_PORT, (char *)bullet_state_tosend, strlen(bullet_state_tosend))) {
@@ -33,9 +36,9 @@ void vSendBulletState(char *bullet_state_tosend)
     }
 }
 
-void vComputeDiffString(char *tosend)
+void vComputeDiffString(const world_snapshot_t *world, char *tosend)
 {
-    int diff = my_spaceship.x - my_mothership.x;
+    int diff = world->spaceship_x - world->mothership_x;
     char number_str[4];
 
     //inserts - or + in the string depending on if
@@ -52,11 +55,11 @@ void vComputeDiffString(char *tosend)
     strcat(tosend, number_str);
 }
 
-void vSendSpaceshipMothershipDiff(void)
+void vSendSpaceshipMothershipDiff(const world_snapshot_t *world)
 {
     char tosend[5] = {'\0'};
 
-    vComputeDiffString(tosend);
+    vComputeDiffString(world, tosend);
 
     if(aIOSocketPut(UDP, IPv4_addr, UDP_TRANSMIT_PORT, tosend, strlen(tosend))) {
         PRINT_ERROR("Failed to position diference to opponent");
@@ -78,21 +81,25 @@ void vReceiveCallback(size_t receive_size, char *buffer, void *args)
 {
     if (vCheckCanReceiveData()) {
         if (strcmp(buffer, "INC") == 0) {
-            my_mothership.direction = LEFT_TO_RIGHT;
+            opponent_direction = LEFT_TO_RIGHT;
             prints("Received order to increment position\n");
         }
         if (strcmp(buffer, "DEC") == 0) {
-            my_mothership.direction = RIGHT_TO_LEFT;
+            opponent_direction = RIGHT_TO_LEFT;
             prints("Received order to decrement position\n");
         }
         if (strcmp(buffer, "HALT") == 0) {
-            my_mothership.direction = STOP;
+            opponent_direction = STOP;
             prints("Received order to stop\n");
         }
-        xSemaphoreGive(my_mothership.lock);
     }
 }
 
+int vGetOpponentDirection(void)
+{
+    return opponent_direction;
+}
+
 void vInitPVP(void)
 {
     UDP_receive_handle = aIOOpenUDPSocket(IPv4_addr, UDP_RECEIVE_PORT, 2000, 
@@ -0,0 +1,380 @@
+#include <stdint.h>
+#include <stdio.h>
+#include <string.h>
+
+#include "replay.h"
+#include "wave_pack.h"
+
+static void vWriteVarint(FILE *fp, uint32_t value)
+{
+    while (value >= 0x80) {
+        fputc((value & 0x7F) | 0x80, fp);
+        value >>= 7;
+    }
+    fputc(value, fp);
+}
+
+/**
+ * @brief Reads a varint written by vWriteVarint.
+ *
+ * @return 1 if one was read, 0 if the file ended right before it
+ * and -1 if it ended in the middle of it or the varint is too long.
+ */
+static int xReadVarint(FILE *fp, uint32_t *value)
+{
+    int byte, shift;
+
+    *value = 0;
+    for (shift = 0; shift < 35; shift += 7) {
+        byte = fgetc(fp);
+        if (byte == EOF)
+            return shift ? -1 : 0;
+        *value |= (uint32_t)(byte & 0x7F) << shift;
+        if (!(byte & 0x80))
+            return 1;
+    }
+
+    return -1;
+}
+
+//keeps small negative values small
+static uint32_t uZigZag(int value)
+{
+    return ((uint32_t)value << 1) ^ (uint32_t)(value >> 31);
+}
+
+static int xUnZigZag(uint32_t value)
+{
+    return (int)(value >> 1) ^ -(int)(value & 1);
+}
+
+static void vWriteInt(FILE *fp, int value)
+{
+    vWriteVarint(fp, uZigZag(value));
+}
+
+static int xReadInt(FILE *fp, int *value)
+{
+    uint32_t v;
+
+    if (xReadVarint(fp, &v) != 1)
+        return -1;
+    *value = xUnZigZag(v);
+
+    return 0;
+}
+
+static void vWriteRecord(FILE *fp, int type, uint32_t value)
+{
+    vWriteVarint(fp, value << REPLAY_TYPE_BITS | type);
+}
+
+static void vWriteWave(FILE *fp, const wave_t *wave)
+{
+    fwrite(wave, sizeof(*wave), 1, fp);
+}
+
+static int xReadWave(FILE *fp, wave_t *wave)
+{
+    if (fread(wave, sizeof(*wave), 1, fp) != 1 || !vWaveIsValid(wave))
+        return -1;
+
+    return 0;
+}
+
+static uint32_t uPackDirection(int direction)
+{
+    switch (direction) {
+        case LEFT_TO_RIGHT:
+            return 1;
+        case RIGHT_TO_LEFT:
+            return 2;
+        default:
+            return 0;
+    }
+}
+
+static int xUnpackDirection(uint32_t packed)
+{
+    switch (packed & 3) {
+        case 1:
+            return LEFT_TO_RIGHT;
+        case 2:
+            return RIGHT_TO_LEFT;
+        default:
+            return STOP;
+    }
+}
+
+/**
+ * @brief Packs an input in 5 bits, the move in the first two, the
+ * shot in the third and the mothership direction in the last two.
+ *
+ */
+static uint32_t uPackInput(const input_t *input)
+{
+    return uPackDirection(input->move) | (input->shoot ? 1 : 0) << 2
+           | uPackDirection(input->mothership_direction) << 3;
+}
+
+static void vUnpackInput(uint32_t packed, input_t *input)
+{
+    input->move = xUnpackDirection(packed);
+    input->shoot = (packed >> 2) & 1;
+    input->mothership_direction = xUnpackDirection(packed >> 3);
+}
+
+static void vWriteConfig(FILE *fp, const world_config_t *config)
+{
+    int i;
+
+    vWriteInt(fp, config->board_width);
+    vWriteInt(fp, config->board_height);
+    vWriteInt(fp, config->spaceship_width);
+    vWriteInt(fp, config->spaceship_height);
+    for (i = 0; i < N_MONSTER_TYPES; i++) {
+        vWriteInt(fp, config->monster_width[i]);
+        vWriteInt(fp, config->monster_height[i]);
+    }
+    vWriteInt(fp, config->mothership_width);
+    vWriteInt(fp, config->mothership_height);
+}
+
+//every size is used to lay out the board, none may be empty
+static int xSizeIsValid(int size, int board_size)
+{
+    return size >= 1 && size <= board_size;
+}
+
+static int xReadConfig(FILE *fp, world_config_t *config)
+{
+    int i, ret = 0;
+
+    ret |= xReadInt(fp, &config->board_width);
+    ret |= xReadInt(fp, &config->board_height);
+    ret |= xReadInt(fp, &config->spaceship_width);
+    ret |= xReadInt(fp, &config->spaceship_height);
+    for (i = 0; i < N_MONSTER_TYPES; i++) {
+        ret |= xReadInt(fp, &config->monster_width[i]);
+        ret |= xReadInt(fp, &config->monster_height[i]);
+    }
+    ret |= xReadInt(fp, &config->mothership_width);
+    ret |= xReadInt(fp, &config->mothership_height);
+    if (ret)
+        return -1;
+
+    if (!xSizeIsValid(config->board_width, REPLAY_MAX_BOARD_SIZE)
+            || !xSizeIsValid(config->board_height, REPLAY_MAX_BOARD_SIZE)
+            || !xSizeIsValid(config->spaceship_width, config->board_width)
+            || !xSizeIsValid(config->spaceship_height, config->board_height)
+            || !xSizeIsValid(config->mothership_width, config->board_width)
+            || !xSizeIsValid(config->mothership_height, config->board_height))
+        return -1;
+    for (i = 0; i < N_MONSTER_TYPES; i++)
+        if (!xSizeIsValid(config->monster_width[i], config->board_width)
+                || !xSizeIsValid(config->monster_height[i],
+                                 config->board_height))
+            return -1;
+
+    return 0;
+}
+
+/**
+ * @brief Writes the run of equal steps held back, if any.
+ *
+ */
+static void vFlushSteps(replay_t *replay)
+{
+    if (!replay->n_steps)
+        return;
+
+    vWriteRecord(replay->fp, REPLAY_STEP, replay->dt_ms);
+    if (replay->n_steps > 1)
+        vWriteRecord(replay->fp, REPLAY_REPEAT, replay->n_steps - 1);
+    replay->n_steps = 0;
+}
+
+int vReplayCreate(replay_t *replay, const char *path,
+                  const replay_header_t *header)
+{
+    uint32_t magic = REPLAY_MAGIC;
+    int k;
+
+    memset(replay, 0, sizeof(*replay));
+
+    replay->fp = fopen(path, "wb");
+    if (!replay->fp)
+        return -1;
+
+    for (k = 0; k < 4; k++)
+        fputc((magic >> (8 * k)) & 0xFF, replay->fp);
+    vWriteVarint(replay->fp, REPLAY_VERSION);
+    vWriteVarint(replay->fp, header->seed);
+    vWriteConfig(replay->fp, &header->config);
+    vWriteWave(replay->fp, &header->wave);
+
+    return ferror(replay->fp) ? -1 : 0;
+}
+
+void vReplayStep(replay_t *replay, const input_t *input, uint32_t dt_ms)
+{
+    uint32_t packed;
+
+    if (!replay->fp)
+        return;
+
+    packed = uPackInput(input);
+    if (packed != replay->input) {
+        vFlushSteps(replay);
+        vWriteRecord(replay->fp, REPLAY_INPUT, packed);
+        replay->input = packed;
+    }
+
+    if (replay->n_steps && dt_ms == replay->dt_ms) {
+        replay->n_steps++;
+        return;
+    }
+
+    vFlushSteps(replay);
+    replay->dt_ms = dt_ms;
+    replay->n_steps = 1;
+}
+
+void vReplayStartMatch(replay_t *replay, int n_players, int n_lives,
+                       int score, const wave_t *wave,
+                       int monster_delay_offset_ms)
+{
+    if (!replay->fp)
+        return;
+
+    vFlushSteps(replay);
+    vWriteRecord(replay->fp, REPLAY_MATCH, n_players);
+    vWriteInt(replay->fp, n_lives);
+    vWriteInt(replay->fp, score);
+    vWriteInt(replay->fp, monster_delay_offset_ms);
+    vWriteWave(replay->fp, wave);
+}
+
+void vReplayResetBoard(replay_t *replay, const wave_t *wave,
+                       int monster_delay_offset_ms)
+{
+    if (!replay->fp)
+        return;
+
+    vFlushSteps(replay);
+    vWriteRecord(replay->fp, REPLAY_BOARD, 0);
+    vWriteInt(replay->fp, monster_delay_offset_ms);
+    vWriteWave(replay->fp, wave);
+}
+
+void vReplayMark(replay_t *replay, int type)
+{
+    if (!replay->fp)
+        return;
+
+    vFlushSteps(replay);
+    vWriteRecord(replay->fp, type, 0);
+}
+
+void vReplayClose(replay_t *replay)
+{
+    if (!replay->fp)
+        return;
+
+    vFlushSteps(replay);
+    fclose(replay->fp);
+    replay->fp = NULL;
+}
+
+int vReplayOpen(replay_t *replay, const char *path, replay_header_t *header)
+{
+    uint32_t magic = 0, version;
+    int k, byte;
+
+    memset(replay, 0, sizeof(*replay));
+
+    replay->fp = fopen(path, "rb");
+    if (!replay->fp)
+        return -1;
+
+    for (k = 0; k < 4; k++) {
+        byte = fgetc(replay->fp);
+        if (byte == EOF)
+            goto err_invalid;
+        magic |= (uint32_t)byte << (8 * k);
+    }
+    if (magic != REPLAY_MAGIC)
+        goto err_invalid;
+    if (xReadVarint(replay->fp, &version) != 1 || version != REPLAY_VERSION)
+        goto err_invalid;
+    if (xReadVarint(replay->fp, &header->seed) != 1)
+        goto err_invalid;
+    if (xReadConfig(replay->fp, &header->config))
+        goto err_invalid;
+    if (xReadWave(replay->fp, &header->wave))
+        goto err_invalid;
+
+    return 0;
+
+err_invalid:
+    fclose(replay->fp);
+    replay->fp = NULL;
+    return -1;
+}
+
+int vReplayNext(replay_t *replay, replay_event_t *event)
+{
+    uint32_t record, value;
+    int ret;
+
+    //the input alone changes nothing, it comes with the next step
+    for (;;) {
+        ret = xReadVarint(replay->fp, &record);
+        if (ret != 1)
+            return ret;
+
+        event->type = record & ((1 << REPLAY_TYPE_BITS) - 1);
+        value = record >> REPLAY_TYPE_BITS;
+        if (event->type != REPLAY_INPUT)
+            break;
+        replay->input = value;
+    }
+
+    switch (event->type) {
+        case REPLAY_STEP:
+            replay->dt_ms = value;
+            event->n_steps = 1;
+            break;
+        case REPLAY_REPEAT:
+            event->type = REPLAY_STEP;
+            event->n_steps = value;
+            break;
+        case REPLAY_MATCH:
+            if (value != 1 && value != 2)
+                return -1;
+            event->n_players = value;
+            if (xReadInt(replay->fp, &event->n_lives)
+                    || xReadInt(replay->fp, &event->score))
+                return -1;
+            //fall through
+        case REPLAY_BOARD:
+            if (xReadInt(replay->fp, &event->monster_delay_offset_ms)
+                    || xReadWave(replay->fp, &event->wave))
+                return -1;
+            //the march delay of the wave is at least 1 ms
+            if (event->monster_delay_offset_ms < 0
+                    || event->monster_delay_offset_ms > MAX_MONSTER_DELAY_OFFSET)
+                return -1;
+            return 1;
+        case REPLAY_PAUSE:
+        case REPLAY_COIN:
+            return 1;
+        default:
+            return -1;
+    }
+
+    event->dt_ms = replay->dt_ms;
+    vUnpackInput(replay->input, &event->input);
+
+    return 1;
+}
@@ -0,0 +1,40 @@
+#include <stdint.h>
+
+#include "rng.h"
+
+#define PCG_MULTIPLIER 6364136223846793005ull
+
+void vRngSeed(rng_t *rng, uint64_t seed, uint64_t stream)
+{
+    rng->state = 0;
+    rng->inc = stream << 1 | 1;
+    uRngNext(rng);
+    rng->state += seed;
+    uRngNext(rng);
+}
+
+uint32_t uRngNext(rng_t *rng)
+{
+    uint64_t old = rng->state;
+    uint32_t xorshifted, rot;
+
+    rng->state = old * PCG_MULTIPLIER + rng->inc;
+
+    //XSH RR output: the high bits are shuffled and rotated by the top 5
+    xorshifted = ((old >> 18) ^ old) >> 27;
+    rot = old >> 59;
+    return (xorshifted >> rot) | (xorshifted << ((-rot) & 31));
+}
+
+uint32_t uRngBelow(rng_t *rng, uint32_t bound)
+{
+    //numbers below threshold would make the low values more likely
+    uint32_t threshold = -bound % bound;
+    uint32_t r;
+
+    do {
+        r = uRngNext(rng);
+    } while (r < threshold);
+
+    return r % bound;
+}
@@ -0,0 +1,142 @@
+#include <signal.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <string.h>
+
+#include "FreeRTOS.h"
+#include "task.h"
+
+#include "TUM_Print.h"
+
+#include "run_stats.h"
+
+/**
+ * @brief What a task had used up when the last sample was taken,
+ * tasks are told apart by their number since handles can be reused.
+ *
+ */
+typedef struct run_stats_task {
+    UBaseType_t number;
+    uint32_t run_time; /**< in microseconds, wraps like the kernel's */
+    unsigned long runs;
+    unsigned long preemptions;
+} run_stats_task_t;
+
+static run_stats_task_t last_tasks[RUN_STATS_MAX_TASKS];
+static UBaseType_t n_last_tasks;
+static uint32_t last_total_run_time;
+//kept apart from the 32 bit run time, which wraps after 71 minutes
+static uint64_t sampled_us;
+
+static volatile sig_atomic_t requested;
+
+static void vRunStatsSignalHandler(int sig)
+{
+    requested = 1;
+}
+
+/**
+ * @brief Reads the run time and switch counts of every task.
+ *
+ * @return Number of tasks read, 0 if there are more than
+ * RUN_STATS_MAX_TASKS.
+ */
+static UBaseType_t uxRunStatsRead(run_stats_task_t *tasks,
+                                  TaskStatus_t *status, uint32_t *total)
+{
+    UBaseType_t n, i;
+
+    n = uxTaskGetSystemState(status, RUN_STATS_MAX_TASKS, total);
+    for (i = 0; i < n; i++) {
+        tasks[i].number = status[i].xTaskNumber;
+        tasks[i].run_time = status[i].ulRunTimeCounter;
+        vPortGetTaskSwitchCounts(status[i].xHandle, &tasks[i].runs,
+                                 &tasks[i].preemptions);
+    }
+
+    return n;
+}
+
+static const run_stats_task_t *xRunStatsLast(UBaseType_t number)
+{
+    static const run_stats_task_t none = { 0 };
+    UBaseType_t i;
+
+    for (i = 0; i < n_last_tasks; i++)
+        if (last_tasks[i].number == number)
+            return &last_tasks[i];
+
+    //created since the last sample
+    return &none;
+}
+
+void vRunStatsInit(void)
+{
+    TaskStatus_t status[RUN_STATS_MAX_TASKS];
+    struct sigaction action = { 0 };
+
+    action.sa_handler = vRunStatsSignalHandler;
+    action.sa_flags = SA_RESTART;
+    sigemptyset(&action.sa_mask);
+    sigaction(RUN_STATS_SIGNAL, &action, NULL);
+
+    n_last_tasks = uxRunStatsRead(last_tasks, status, &last_total_run_time);
+    sampled_us = last_total_run_time;
+}
+
+int xRunStatsRequested(void)
+{
+    if (!requested)
+        return 0;
+    requested = 0;
+
+    return 1;
+}
+
+void vRunStatsHeader(FILE *fp)
+{
+    fprintf(fp, "time_s,state,task,cpu_percent,runs,preemptions\n");
+}
+
+void vRunStatsSample(FILE *fp, const char *state)
+{
+    TaskStatus_t status[RUN_STATS_MAX_TASKS];
+    run_stats_task_t tasks[RUN_STATS_MAX_TASKS];
+    const run_stats_task_t *last;
+    uint32_t total, elapsed;
+    UBaseType_t n, i;
+
+    n = uxRunStatsRead(tasks, status, &total);
+    if (!n)
+        return;
+
+    elapsed = total - last_total_run_time;
+    sampled_us += elapsed;
+    if (elapsed)
+        for (i = 0; i < n; i++) {
+            last = xRunStatsLast(tasks[i].number);
+            fprintf(fp, "%.3f,%s,%s,%.1f,%lu,%lu\n", sampled_us / 1e6, state,
+                    status[i].pcTaskName,
+                    100.0 * (uint32_t)(tasks[i].run_time - last->run_time)
+                    / elapsed,
+                    tasks[i].runs - last->runs,
+                    tasks[i].preemptions - last->preemptions);
+        }
+
+    memcpy(last_tasks, tasks, n * sizeof(*tasks));
+    n_last_tasks = n;
+    last_total_run_time = total;
+}
+
+void vRunStatsPrint(void)
+{
+    static char buffer[RUN_STATS_MAX_TASKS * 64];
+    char *line;
+
+    vTaskGetRunTimeStats(buffer);
+
+    //one line at a time, a safe print only holds SAFE_PRINT_MAX_MSG_LEN
+    prints("Task\t\tRun time\tShare\n");
+    for (line = strtok(buffer, "\r\n"); line; line = strtok(NULL, "\r\n"))
+        prints("%s\n", line);
+}
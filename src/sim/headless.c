@@ -0,0 +1,384 @@
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+
+#include <sys/resource.h>
+
+#include "world.h"
+#include "wave_pack.h"
+#include "replay.h"
+
+#define DEFAULT_MINUTES 10
+#define DEFAULT_SEED 1
+#define DEFAULT_PLAYERS 1
+
+#define SWEEP_TICKS 250 /**< ticks the scripted player moves one way */
+#define OPPONENT_TICKS 180 /**< ticks the scripted opponent moves one way */
+
+/**
+ * @brief Counts every allocation made by the process, the linker
+ * redirects malloc, calloc and realloc here.
+ *
+ */
+static unsigned long n_allocations;
+static unsigned long allocated_bytes;
+
+void *__real_malloc(size_t size);
+void *__real_calloc(size_t n, size_t size);
+void *__real_realloc(void *ptr, size_t size);
+
+void *__wrap_malloc(size_t size)
+{
+    n_allocations++;
+    allocated_bytes += size;
+    return __real_malloc(size);
+}
+
+void *__wrap_calloc(size_t n, size_t size)
+{
+    n_allocations++;
+    allocated_bytes += n * size;
+    return __real_calloc(n, size);
+}
+
+void *__wrap_realloc(void *ptr, size_t size)
+{
+    n_allocations++;
+    allocated_bytes += size;
+    return __real_realloc(ptr, size);
+}
+
+//too big for the stack
+static world_t world;
+
+static wave_pack_t wave_pack;
+static wave_t original_wave;
+
+//the scripted run is recorded only if a path is given
+static replay_t replay;
+
+/**
+ * @brief Gets the wave to play after index waves were cleared,
+ * from the pack if one was given.
+ *
+ */
+static const wave_t *xGetWave(unsigned int index)
+{
+    const wave_t *wave = vWavePackWave(&wave_pack, index);
+
+    return wave ? wave : &original_wave;
+}
+
+/**
+ * @brief Sizes of the game's images, so that the simulation
+ * plays the same match as the game. The board and the formation
+ * are sized from the command line.
+ *
+ */
+static world_config_t config = {
+    .spaceship_width = 27,
+    .spaceship_height = 17,
+    .monster_width = { 34 / 2, 46 / 2, 51 / 2 },
+    .monster_height = { 17, 18, 17 },
+    .mothership_width = 51,
+    .mothership_height = 22,
+};
+
+/**
+ * @brief Scripted player: sweeps the spaceship from side to side
+ * shooting whenever it can. The opponent sweeps the mothership.
+ *
+ */
+static void vScriptInput(const world_t *world, input_t *input)
+{
+    input->move = (world->tick / SWEEP_TICKS) % 2 ? RIGHT_TO_LEFT : LEFT_TO_RIGHT;
+    input->shoot = 1;
+    input->mothership_direction =
+        (world->tick / OPPONENT_TICKS) % 2 ? RIGHT_TO_LEFT : LEFT_TO_RIGHT;
+}
+
+static double dSecondsSince(const struct timespec *start)
+{
+    struct timespec now;
+
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    return (now.tv_sec - start->tv_sec) + (now.tv_nsec - start->tv_nsec) / 1e9;
+}
+
+static uint32_t uHash(uint32_t hash, const void *data, size_t size)
+{
+    const unsigned char *bytes = data;
+    size_t k;
+
+    //FNV-1a
+    for (k = 0; k < size; k++) {
+        hash ^= bytes[k];
+        hash *= 16777619u;
+    }
+
+    return hash;
+}
+
+/**
+ * @brief Sums up the parts of the world a change in the game logic
+ * would show in, so that runs can be compared between commits.
+ *
+ */
+static uint32_t uWorldChecksum(const world_t *world)
+{
+    const formation_t *f = &world->formation;
+    uint32_t hash = 2166136261u;
+    int i;
+
+    hash = uHash(hash, &world->tick, sizeof(world->tick));
+    hash = uHash(hash, &world->score1, sizeof(world->score1));
+    hash = uHash(hash, &world->score2, sizeof(world->score2));
+    hash = uHash(hash, &world->n_lives, sizeof(world->n_lives));
+    hash = uHash(hash, &world->spaceship_x, sizeof(world->spaceship_x));
+    hash = uHash(hash, &world->mothership_x, sizeof(world->mothership_x));
+    for (i = 0; i < f->n_rows; i++) {
+        hash = uHash(hash, f->row_alive[i],
+                     FORMATION_WORDS(f->n_columns) * sizeof(f->row_alive[i][0]));
+        hash = uHash(hash, &f->origin_x[i], sizeof(f->origin_x[i]));
+        hash = uHash(hash, &f->origin_y[i], sizeof(f->origin_y[i]));
+    }
+    hash = uHash(hash, world->bunker, sizeof(world->bunker));
+    hash = uHash(hash, &world->bullets.count, sizeof(world->bullets.count));
+
+    return hash;
+}
+
+/**
+ * @brief The original wave plays on the game's screen, bigger waves
+ * get a board grown in the same proportion so that they have as much
+ * room to march before invading.
+ *
+ */
+static void vSizeBoard(world_config_t *config, int n_rows, int n_columns)
+{
+    config->board_width = SCREEN_WIDTH;
+    if (n_columns > N_COLUMNS)
+        config->board_width = SCREEN_WIDTH * n_columns / N_COLUMNS;
+    config->board_height = SCREEN_HEIGHT;
+    if (n_rows > N_ROWS)
+        config->board_height = SCREEN_HEIGHT * n_rows / N_ROWS;
+}
+
+/**
+ * @brief Plays a recorded session back as fast as possible, the
+ * world is stepped exactly as it was while recording so the checksum
+ * comes out the same on every run of the same code.
+ *
+ * @param path Path of the replay.
+ * @return EXIT_SUCCESS, or EXIT_FAILURE if the replay cannot be read.
+ */
+static int xPlayReplay(const char *path)
+{
+    //the world keeps pointing at the wave of the last match or board
+    static replay_event_t event;
+    static replay_header_t header;
+    unsigned long n_ticks, n_steps = 0, n_tests = 0, n_matches = 0;
+    unsigned long n_waves = 0, n_pauses = 0, n_coins = 0, k;
+    struct timespec start;
+    double seconds;
+    int ret;
+
+    if (vReplayOpen(&replay, path, &header)) {
+        fprintf(stderr, "%s is not a valid replay\n", path);
+        return EXIT_FAILURE;
+    }
+
+    world_init(&world, &header.config, &header.wave, header.seed);
+
+    clock_gettime(CLOCK_MONOTONIC, &start);
+
+    while ((ret = vReplayNext(&replay, &event)) == 1) {
+        switch (event.type) {
+            case REPLAY_STEP:
+                for (k = 0; k < event.n_steps; k++)
+                    world_step(&world, &event.input, event.dt_ms);
+                n_steps += event.n_steps;
+                break;
+            case REPLAY_MATCH:
+                world_start_match(&world, event.n_players, event.n_lives,
+                                  event.score, &event.wave,
+                                  event.monster_delay_offset_ms);
+                n_matches++;
+                break;
+            case REPLAY_BOARD:
+                world_reset_board(&world, &event.wave,
+                                  event.monster_delay_offset_ms);
+                n_waves++;
+                break;
+            case REPLAY_PAUSE:
+                n_pauses++;
+                break;
+            case REPLAY_COIN:
+                n_coins++;
+                break;
+        }
+    }
+
+    seconds = dSecondsSince(&start);
+    //a step can run several ticks, the grid counts every one of them
+    n_tests = world.grid.narrowphase_tests_total;
+    vReplayClose(&replay);
+    if (ret < 0) {
+        fprintf(stderr, "%s is damaged after %lu steps\n", path, n_steps);
+        return EXIT_FAILURE;
+    }
+
+    n_ticks = world.tick;
+    printf("played %lu steps (%lu ticks, %.1f min) in %.3f s\n", n_steps,
+           n_ticks, n_ticks * WORLD_TICK_MS / 60000.0, seconds);
+    printf("ticks/s %.0f\n", n_ticks / seconds);
+    printf("colision tests/s %.0f\n", n_tests / seconds);
+    printf("pauses %lu coins %lu\n", n_pauses, n_coins);
+    printf("matches %lu waves cleared %lu checksum 0x%08x\n", n_matches,
+           n_waves, uWorldChecksum(&world));
+
+    return EXIT_SUCCESS;
+}
+
+static void vUsage(const char *name)
+{
+    fprintf(stderr, "usage: %s [-r replay to record] [minutes] [seed] "
+            "[1|2 players] [rows up to %d] [columns up to %d] [wave pack]\n"
+            "       %s -p replay to play\n", name,
+            FORMATION_MAX_ROWS, FORMATION_MAX_COLUMNS, name);
+}
+
+int main(int argc, char *argv[])
+{
+    const char *record_path = NULL;
+    double minutes = DEFAULT_MINUTES;
+    uint32_t seed = DEFAULT_SEED;
+    int n_players = DEFAULT_PLAYERS;
+    int n_rows = N_ROWS;
+    int n_columns = N_COLUMNS;
+    const char *wave_pack_path = NULL;
+    unsigned long n_ticks, k, n_tests = 0, n_matches = 1, n_waves = 0;
+    unsigned int w, wave_index = 0;
+    unsigned long allocations_before, bytes_before;
+    replay_header_t header;
+    struct timespec start;
+    struct rusage usage;
+    double seconds;
+    input_t input;
+    int opt;
+
+    while ((opt = getopt(argc, argv, "r:p:")) != -1) {
+        switch (opt) {
+            case 'r':
+                record_path = optarg;
+                break;
+            case 'p':
+                return xPlayReplay(optarg);
+            default:
+                vUsage(argv[0]);
+                return EXIT_FAILURE;
+        }
+    }
+    argc -= optind - 1;
+    argv += optind - 1;
+
+    if (argc > 1)
+        minutes = atof(argv[1]);
+    if (argc > 2)
+        seed = strtoul(argv[2], NULL, 0);
+    if (argc > 3)
+        n_players = atoi(argv[3]);
+    if (argc > 4)
+        n_rows = atoi(argv[4]);
+    if (argc > 5)
+        n_columns = atoi(argv[5]);
+    if (argc > 6)
+        wave_pack_path = argv[6];
+
+    if (minutes <= 0 || (n_players != 1 && n_players != 2)
+            || n_rows < 1 || n_rows > FORMATION_MAX_ROWS
+            || n_columns < 1 || n_columns > FORMATION_MAX_COLUMNS) {
+        vUsage(argv[0]);
+        return EXIT_FAILURE;
+    }
+
+    n_ticks = minutes * 60 * 1000 / WORLD_TICK_MS;
+
+    world_original_wave(&original_wave, n_rows, n_columns);
+    if (wave_pack_path) {
+        if (vWavePackOpen(&wave_pack, wave_pack_path)) {
+            fprintf(stderr, "%s is not a valid wave pack\n", wave_pack_path);
+            return EXIT_FAILURE;
+        }
+        //the board fits the biggest formation of the pack
+        n_rows = n_columns = 1;
+        for (w = 0; w < wave_pack.n_waves; w++) {
+            if (wave_pack.waves[w].formation_rows > n_rows)
+                n_rows = wave_pack.waves[w].formation_rows;
+            if (wave_pack.waves[w].formation_columns > n_columns)
+                n_columns = wave_pack.waves[w].formation_columns;
+        }
+    }
+
+    vSizeBoard(&config, n_rows, n_columns);
+    world_init(&world, &config, xGetWave(0), seed);
+    world_start_match(&world, n_players, INITIAL_LIVES, 0, xGetWave(0), 0);
+
+    if (record_path) {
+        header.seed = seed;
+        header.config = config;
+        header.wave = *xGetWave(0);
+        if (vReplayCreate(&replay, record_path, &header)) {
+            fprintf(stderr, "Could not create %s\n", record_path);
+            return EXIT_FAILURE;
+        }
+        vReplayStartMatch(&replay, n_players, INITIAL_LIVES, 0, xGetWave(0), 0);
+    }
+
+    allocations_before = n_allocations;
+    bytes_before = allocated_bytes;
+    clock_gettime(CLOCK_MONOTONIC, &start);
+
+    for (k = 0; k < n_ticks; k++) {
+        vScriptInput(&world, &input);
+        vReplayStep(&replay, &input, WORLD_TICK_MS);
+        world_step(&world, &input, WORLD_TICK_MS);
+
+        //same as the game, without the second of pause
+        if (world.status == WORLD_PLAYER_DEAD) {
+            wave_index = 0;
+            vReplayStartMatch(&replay, n_players, INITIAL_LIVES, 0,
+                              xGetWave(wave_index), 0);
+            world_start_match(&world, n_players, INITIAL_LIVES, 0,
+                              xGetWave(wave_index), 0);
+            n_matches++;
+        } else if (world.status == WORLD_WAVE_CLEARED) {
+            wave_index++;
+            vReplayResetBoard(&replay, xGetWave(wave_index), 0);
+            world_reset_board(&world, xGetWave(wave_index), 0);
+            n_waves++;
+        }
+    }
+
+    seconds = dSecondsSince(&start);
+    n_tests = world.grid.narrowphase_tests_total;
+    vReplayClose(&replay);
+    getrusage(RUSAGE_SELF, &usage);
+
+    printf("simulated %.1f min (%lu ticks) in %.3f s\n", minutes, n_ticks, seconds);
+    printf("formation %dx%d on a %dx%d board\n", n_rows, n_columns,
+           config.board_width, config.board_height);
+    printf("ticks/s %.0f\n", n_ticks / seconds);
+    printf("colision tests/s %.0f (%.2f per tick)\n", n_tests / seconds,
+           (double)n_tests / n_ticks);
+    printf("allocations %lu (%lu bytes)\n", n_allocations - allocations_before,
+           allocated_bytes - bytes_before);
+    printf("peak RSS %ld kB\n", usage.ru_maxrss);
+    printf("matches %lu waves cleared %lu checksum 0x%08x\n", n_matches, n_waves,
+           uWorldChecksum(&world));
+
+    return EXIT_SUCCESS;
+}
@@ -0,0 +1,134 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+
+#include "FreeRTOS.h"
+#include "queue.h"
+#include "task.h"
+#include "mailbox.h"
+
+#define DEFAULT_ITERATIONS 10000000UL
+
+#define BENCH_STACK_SIZE ((unsigned short)2560)
+
+static unsigned long n_iterations = DEFAULT_ITERATIONS;
+
+static QueueHandle_t state_queue = NULL;
+static MailboxHandle_t state_mailbox = NULL;
+
+//keeps the reads from being optimised away
+static volatile unsigned char sink;
+
+static double dSecondsSince(const struct timespec *start)
+{
+    struct timespec now;
+
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    return (now.tv_sec - start->tv_sec) + (now.tv_nsec - start->tv_nsec) / 1e9;
+}
+
+static void vReport(const char *name, const struct timespec *start)
+{
+    printf("%-28s %8.1f ns/op\n", name, dSecondsSince(start) * 1e9 / n_iterations);
+}
+
+/**
+ * @brief Times every way the game reads and writes its one element
+ * shared variables, the old queues against the mailboxes. Runs as a
+ * task so that the queue functions take their usual path through the
+ * scheduler.
+ *
+ */
+static void vBench(void *pvParameters)
+{
+    struct timespec start;
+    unsigned char state = 1;
+    uint32_t version = 0;
+    unsigned long k;
+
+    clock_gettime(CLOCK_MONOTONIC, &start);
+    for (k = 0; k < n_iterations; k++) {
+        xQueuePeek(state_queue, &state, 0);
+        sink = state;
+    }
+    vReport("xQueuePeek", &start);
+
+    clock_gettime(CLOCK_MONOTONIC, &start);
+    for (k = 0; k < n_iterations; k++) {
+        ulMailboxRead(state_mailbox, &state);
+        sink = state;
+    }
+    vReport("ulMailboxRead", &start);
+
+    version = ulMailboxRead(state_mailbox, &state);
+    clock_gettime(CLOCK_MONOTONIC, &start);
+    for (k = 0; k < n_iterations; k++) {
+        xMailboxReadIfChanged(state_mailbox, &state, &version);
+        sink = state;
+    }
+    vReport("xMailboxReadIfChanged", &start);
+
+    clock_gettime(CLOCK_MONOTONIC, &start);
+    for (k = 0; k < n_iterations; k++) {
+        state = k;
+        xQueueOverwrite(state_queue, &state);
+    }
+    vReport("xQueueOverwrite", &start);
+
+    clock_gettime(CLOCK_MONOTONIC, &start);
+    for (k = 0; k < n_iterations; k++) {
+        state = k;
+        vMailboxWrite(state_mailbox, &state);
+    }
+    vReport("vMailboxWrite", &start);
+
+    //the POSIX port cannot end its scheduler cleanly
+    exit(EXIT_SUCCESS);
+}
+
+int main(int argc, char *argv[])
+{
+    unsigned char state = 1;
+
+    if (argc > 1)
+        n_iterations = strtoul(argv[1], NULL, 0);
+    if (!n_iterations) {
+        fprintf(stderr, "usage: %s [iterations]\n", argv[0]);
+        return EXIT_FAILURE;
+    }
+
+    state_queue = xQueueCreate(1, sizeof(unsigned char));
+    if (!state_queue)
+        goto err_state_queue;
+    state_mailbox = xMailboxCreate(sizeof(unsigned char));
+    if (!state_mailbox)
+        goto err_state_mailbox;
+
+    xQueueOverwrite(state_queue, &state);
+    vMailboxWrite(state_mailbox, &state);
+
+    if (xTaskCreate(vBench, "Bench", BENCH_STACK_SIZE, NULL,
+                    configMAX_PRIORITIES - 1, NULL) != pdPASS)
+        goto err_bench;
+
+    printf("%lu iterations\n", n_iterations);
+    vTaskStartScheduler();
+
+    return EXIT_SUCCESS;
+
+err_bench:
+    vMailboxDelete(state_mailbox);
+err_state_mailbox:
+    vQueueDelete(state_queue);
+err_state_queue:
+    fprintf(stderr, "Failed to set up the benchmark\n");
+    return EXIT_FAILURE;
+}
+
+__attribute__((unused)) void vMainQueueSendPassed(void)
+{
+}
+
+__attribute__((unused)) void vApplicationIdleHook(void)
+{
+}
@@ -0,0 +1,214 @@
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "world.h"
+#include "wave_pack.h"
+
+#define MAX_WAVES 4096
+#define MAX_LINE 1024
+
+#define DELIMITERS " \t\r\n"
+
+static wave_t waves[MAX_WAVES];
+
+static const char *monster_names[N_MONSTER_TYPES] = {
+    [SMALL_MONSTER] = "small",
+    [MEDIUM_MONSTER] = "medium",
+    [LARGE_MONSTER] = "large",
+};
+
+static const char *source_path;
+static int line_number;
+
+static void vFail(const char *msg, const char *arg)
+{
+    fprintf(stderr, "%s:%d: %s%s%s\n", source_path, line_number, msg,
+            arg ? " " : "", arg ? arg : "");
+    exit(EXIT_FAILURE);
+}
+
+/**
+ * @brief Reads the next number of the line.
+ *
+ */
+static long lNextNumber(long min, long max)
+{
+    char *token = strtok(NULL, DELIMITERS), *end;
+    long value;
+
+    if (!token)
+        vFail("missing number", NULL);
+    value = strtol(token, &end, 0);
+    if (*end || value < min || value > max)
+        vFail("number out of range:", token);
+
+    return value;
+}
+
+static int iMonsterType(const char *name)
+{
+    int k;
+
+    for (k = 0; k < N_MONSTER_TYPES; k++)
+        if (!strcmp(name, monster_names[k]))
+            return k;
+
+    vFail("unknown monster type:", name);
+    return -1;
+}
+
+/**
+ * @brief Applies one line of a wave block. Waves start as the original
+ * wave so a block only lists what it changes.
+ *
+ */
+static void vParseKey(wave_t *wave, const char *key)
+{
+    wave_t sized;
+    char *token, *end;
+    int k;
+
+    if (!strcmp(key, "formation")) {
+        k = lNextNumber(1, FORMATION_MAX_ROWS);
+        //rows get the types of the original formation of that size
+        world_original_wave(&sized, k, lNextNumber(1, FORMATION_MAX_COLUMNS));
+        wave->formation_rows = sized.formation_rows;
+        wave->formation_columns = sized.formation_columns;
+        memcpy(wave->row_type, sized.row_type, sizeof(wave->row_type));
+    } else if (!strcmp(key, "rows")) {
+        for (k = 0; (token = strtok(NULL, DELIMITERS)); k++) {
+            if (k == wave->formation_rows)
+                vFail("more row types than rows", NULL);
+            wave->row_type[k] = iMonsterType(token);
+        }
+        if (k != wave->formation_rows)
+            vFail("fewer row types than rows", NULL);
+    } else if (!strcmp(key, "march")) {
+        wave->monster_delay_ms = lNextNumber(1, UINT16_MAX);
+    } else if (!strcmp(key, "fire")) {
+        wave->fire_period_ms = lNextNumber(WORLD_TICK_MS, INT32_MAX);
+        wave->n_shooters = lNextNumber(0, FORMATION_MAX_COLUMNS);
+        token = strtok(NULL, DELIMITERS);
+        if (!token || !strcmp(token, "random"))
+            wave->aimed = 0;
+        else if (!strcmp(token, "aimed"))
+            wave->aimed = 1;
+        else
+            vFail("expected random or aimed:", token);
+    } else if (!strcmp(key, "mothership")) {
+        wave->mothership_period_ms = lNextNumber(WORLD_TICK_MS, INT32_MAX);
+    } else if (!strcmp(key, "bunkers")) {
+        for (k = 0; k < N_BUNKERS; k++)
+            wave->bunker_x_permille[k] = WAVE_NO_BUNKER;
+        for (k = 0; (token = strtok(NULL, DELIMITERS)); k++) {
+            if (k == N_BUNKERS)
+                vFail("too many bunkers", NULL);
+            if (!strcmp(token, "-"))
+                continue;
+            wave->bunker_x_permille[k] = strtol(token, &end, 0);
+            if (*end || wave->bunker_x_permille[k] > 1000)
+                vFail("bunker beyond the board:", token);
+        }
+    } else {
+        vFail("unknown key:", key);
+    }
+
+    if (strtok(NULL, DELIMITERS))
+        vFail("trailing text after", key);
+}
+
+/**
+ * @brief Reads every wave block of the source.
+ *
+ * @return Number of waves read.
+ */
+static int iParseWaves(FILE *src)
+{
+    char line[MAX_LINE], *key;
+    wave_t *wave = NULL;
+    int n_waves = 0;
+
+    while (fgets(line, sizeof(line), src)) {
+        line_number++;
+        if (strchr(line, '#'))
+            *strchr(line, '#') = '\0';
+        key = strtok(line, DELIMITERS);
+        if (!key)
+            continue;
+
+        if (!strcmp(key, "wave")) {
+            if (wave)
+                vFail("wave inside a wave", NULL);
+            if (n_waves == MAX_WAVES)
+                vFail("too many waves", NULL);
+            wave = &waves[n_waves];
+            world_original_wave(wave, N_ROWS, N_COLUMNS);
+        } else if (!strcmp(key, "end")) {
+            if (!wave)
+                vFail("end outside a wave", NULL);
+            if (!vWaveIsValid(wave))
+                vFail("wave cannot be played", NULL);
+            wave = NULL;
+            n_waves++;
+        } else if (!wave) {
+            vFail("expected wave, got", key);
+        } else {
+            vParseKey(wave, key);
+        }
+    }
+
+    if (wave)
+        vFail("missing end", NULL);
+
+    return n_waves;
+}
+
+int main(int argc, char *argv[])
+{
+    wave_pack_header_t header = { 0 };
+    FILE *src, *out;
+    int n_waves;
+
+    if (argc != 3) {
+        fprintf(stderr, "usage: %s <waves.txt> <waves.bin>\n", argv[0]);
+        return EXIT_FAILURE;
+    }
+
+    source_path = argv[1];
+    src = fopen(source_path, "r");
+    if (!src) {
+        perror(source_path);
+        return EXIT_FAILURE;
+    }
+    n_waves = iParseWaves(src);
+    fclose(src);
+
+    if (!n_waves) {
+        fprintf(stderr, "%s: no waves\n", source_path);
+        return EXIT_FAILURE;
+    }
+
+    header.magic = WAVE_PACK_MAGIC;
+    header.version = WAVE_PACK_VERSION;
+    header.wave_size = WAVE_SIZE;
+    header.n_waves = n_waves;
+
+    out = fopen(argv[2], "wb");
+    if (!out) {
+        perror(argv[2]);
+        return EXIT_FAILURE;
+    }
+    if (fwrite(&header, sizeof(header), 1, out) != 1
+            || fwrite(waves, sizeof(wave_t), n_waves, out) != (size_t)n_waves
+            || fclose(out)) {
+        perror(argv[2]);
+        remove(argv[2]);
+        return EXIT_FAILURE;
+    }
+
+    printf("%s: %d waves\n", argv[2], n_waves);
+
+    return EXIT_SUCCESS;
+}
@@ -0,0 +1,33 @@
+#include "triple_buffer.h"
+
+void vTripleBufferInit(triple_buffer_t *tb)
+{
+    tb->back = 0;
+    tb->middle = 1;
+    tb->front = 2;
+}
+
+int vTripleBufferBack(const triple_buffer_t *tb)
+{
+    return tb->back;
+}
+
+int vTripleBufferPublish(triple_buffer_t *tb)
+{
+    int published = tb->back;
+
+    //release so that the contents are visible before the index
+    tb->back = __atomic_exchange_n(&tb->middle, published | TRIPLE_BUFFER_FRESH,
+                                   __ATOMIC_ACQ_REL) & TRIPLE_BUFFER_INDEX_MASK;
+
+    return published;
+}
+
+int vTripleBufferAcquire(triple_buffer_t *tb)
+{
+    if (__atomic_load_n(&tb->middle, __ATOMIC_RELAXED) & TRIPLE_BUFFER_FRESH)
+        tb->front = __atomic_exchange_n(&tb->middle, tb->front,
+                                        __ATOMIC_ACQ_REL) & TRIPLE_BUFFER_INDEX_MASK;
+
+    return tb->front;
+}
@@ -0,0 +1,101 @@
+#include <fcntl.h>
+#include <stdint.h>
+#include <string.h>
+#include <unistd.h>
+
+#include <sys/mman.h>
+#include <sys/stat.h>
+
+#include "wave_pack.h"
+
+int vWaveIsValid(const wave_t *wave)
+{
+    int i;
+
+    if (wave->formation_rows < 1 || wave->formation_rows > FORMATION_MAX_ROWS)
+        return 0;
+    if (wave->formation_columns < 1
+            || wave->formation_columns > FORMATION_MAX_COLUMNS)
+        return 0;
+    if (wave->fire_period_ms < WORLD_TICK_MS
+            || wave->mothership_period_ms < WORLD_TICK_MS)
+        return 0;
+    //the march divides by it
+    if (wave->monster_delay_ms < 1)
+        return 0;
+
+    for (i = 0; i < wave->formation_rows; i++)
+        if (wave->row_type[i] >= N_MONSTER_TYPES)
+            return 0;
+
+    for (i = 0; i < N_BUNKERS; i++)
+        if (wave->bunker_x_permille[i] != WAVE_NO_BUNKER
+                && wave->bunker_x_permille[i] > 1000)
+            return 0;
+
+    return 1;
+}
+
+int vWavePackOpen(wave_pack_t *pack, const char *path)
+{
+    const wave_pack_header_t *header;
+    struct stat st;
+    void *map;
+    unsigned int k;
+    int fd;
+
+    memset(pack, 0, sizeof(*pack));
+
+    if (!path)
+        return -1;
+    fd = open(path, O_RDONLY);
+    if (fd < 0)
+        return -1;
+    if (fstat(fd, &st) || (size_t)st.st_size < sizeof(wave_pack_header_t)) {
+        close(fd);
+        return -1;
+    }
+
+    map = mmap(NULL, st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+    //the mapping keeps the file alive
+    close(fd);
+    if (map == MAP_FAILED)
+        return -1;
+
+    header = map;
+    if (header->magic != WAVE_PACK_MAGIC || header->version != WAVE_PACK_VERSION
+            || header->wave_size != WAVE_SIZE || header->n_waves == 0
+            || header->n_waves > (st.st_size - sizeof(*header)) / WAVE_SIZE)
+        goto err_invalid;
+
+    pack->map = map;
+    pack->size = st.st_size;
+    pack->waves = (const wave_t *)(header + 1);
+    pack->n_waves = header->n_waves;
+
+    for (k = 0; k < pack->n_waves; k++)
+        if (!vWaveIsValid(&pack->waves[k]))
+            goto err_invalid;
+
+    return 0;
+
+err_invalid:
+    munmap(map, st.st_size);
+    memset(pack, 0, sizeof(*pack));
+    return -1;
+}
+
+void vWavePackClose(wave_pack_t *pack)
+{
+    if (pack->map)
+        munmap((void *)pack->map, pack->size);
+    memset(pack, 0, sizeof(*pack));
+}
+
+const wave_t *vWavePackWave(const wave_pack_t *pack, unsigned int index)
+{
+    if (!pack->n_waves)
+        return NULL;
+
+    return &pack->waves[index % pack->n_waves];
+}
@@ -0,0 +1,1178 @@
+#include <stdint.h>
+#include <string.h>
+
+#include "world.h"
+
+#define BULLET_CHANGE 3
+#define MONSTER_CHANGE 5
+#define MONSTER_STEP_DOWN 10
+#define WALL_MARGIN 10
+#define CHANGE_IN_POSITION_PVP 1
+
+#define HIT_NONE 0
+#define HIT_CEILING 1
+#define HIT_FLOOR 2
+#define HIT_MONSTER 3
+#define HIT_OBJECT 4
+
+//streams of the world's generators, all seeded with the same seed
+#define WORLD_RNG_SHOOTER 1
+#define WORLD_RNG_MOTHERSHIP 2
+
+/**
+ * @brief Earliest hit found along a bullet's path.
+ *
+ */
+typedef struct bullet_hit {
+    int distance;
+    int kind;
+    int i; /**< monster row, or colision grid id */
+    int j; /**< monster column */
+} bullet_hit_t;
+
+//spaceship bullets go up and other bullets go down
+static const int bullet_velocity[BULLET_N_TYPES] = {
+    [SPACESHIP_BULLET] = -BULLET_CHANGE,
+    [MONSTER_BULLET] = BULLET_CHANGE,
+    [MOTHERSHIP_BULLET] = BULLET_CHANGE,
+};
+
+static const int monster_score[N_MONSTER_TYPES] = {
+    [SMALL_MONSTER] = 30,
+    [MEDIUM_MONSTER] = 20,
+    [LARGE_MONSTER] = 10,
+};
+
+static int iBitTest(const uint64_t *bits, int k)
+{
+    return (bits[k / 64] >> (k % 64)) & 1;
+}
+
+static void vBitClear(uint64_t *bits, int k)
+{
+    bits[k / 64] &= ~(1ULL << (k % 64));
+}
+
+/**
+ * @brief Sets the first n bits of a bitset.
+ *
+ */
+static void vBitsetFill(uint64_t *bits, int n)
+{
+    int w;
+
+    for (w = 0; w < n / 64; w++)
+        bits[w] = ~0ULL;
+    if (n % 64)
+        bits[w] = (1ULL << (n % 64)) - 1;
+}
+
+/**
+ * @return Index of the lowest bit set, or -1 if none is.
+ */
+static int iBitsetFirst(const uint64_t *bits, int n_words)
+{
+    int w;
+
+    for (w = 0; w < n_words; w++)
+        if (bits[w])
+            return w * 64 + __builtin_ctzll(bits[w]);
+
+    return -1;
+}
+
+/**
+ * @return Index of the highest bit set, or -1 if none is.
+ */
+static int iBitsetLast(const uint64_t *bits, int n_words)
+{
+    int w;
+
+    for (w = n_words - 1; w >= 0; w--)
+        if (bits[w])
+            return w * 64 + 63 - __builtin_clzll(bits[w]);
+
+    return -1;
+}
+
+/**
+ * @brief Finds the n-th bit set at or after bit from, counting whole
+ * words at a time.
+ *
+ * @return Index of the bit, with n set to 0, or -1 with n decreased by
+ * the number of bits set after from if there are not enough of them.
+ */
+static int iBitsetSelect(const uint64_t *bits, int n_words, int from, int *n)
+{
+    int w = from / 64, count;
+    uint64_t word;
+
+    if (w >= n_words)
+        return -1;
+
+    word = bits[w] & (~0ULL << (from % 64));
+    while (1) {
+        count = __builtin_popcountll(word);
+        if (count >= *n) {
+            while (--*n)
+                word &= word - 1;
+            return w * 64 + __builtin_ctzll(word);
+        }
+        *n -= count;
+        if (++w >= n_words)
+            return -1;
+        word = bits[w];
+    }
+}
+
+static void vGridUpdateSpaceship(world_t *world)
+{
+    vBroadphaseUpdate(&world->grid, GRID_SPACESHIP, world->spaceship_x,
+                      world->spaceship_y, world->config.spaceship_width,
+                      world->config.spaceship_height);
+}
+
+static void vGridUpdateMothership(world_t *world)
+{
+    vBroadphaseUpdate(&world->grid, GRID_MOTHERSHIP, world->mothership_x,
+                      world->mothership_y, world->config.mothership_width,
+                      world->config.mothership_height);
+}
+
+static void vClearTickHits(game_events_t *events)
+{
+    memset(events->monsters_killed, 0, sizeof(events->monsters_killed));
+    events->spaceship_hit = 0;
+    events->mothership_hit = 0;
+}
+
+/**
+ * @brief Appends an event and remembers which object was hit.
+ *
+ */
+static void vPushGameEvent(game_events_t *events, const game_event_t *event)
+{
+    events->event[events->count++] = *event;
+
+    switch (event->type) {
+        case EVENT_MONSTER_KILLED:
+            events->monsters_killed[event->i][event->j / 64] |= 1ULL << (event->j % 64);
+            break;
+        case EVENT_PLAYER_HIT:
+            events->spaceship_hit = 1;
+            break;
+        case EVENT_MOTHERSHIP_HIT:
+            events->mothership_hit = 1;
+            break;
+        default:
+            break;
+    }
+}
+
+static void vResetSpaceship(world_t *world)
+{
+    world->spaceship_x = world->config.board_width / 2 - world->config.spaceship_width / 2;
+    world->spaceship_y = SPACESHIP_Y(world->config.board_height);
+    vGridUpdateSpaceship(world);
+}
+
+static void vMoveSpaceship(world_t *world, int direction)
+{
+    if (direction == STOP)
+        return;
+
+    world->spaceship_x = world->spaceship_x + direction * CHANGE_IN_POSITION;
+    if (world->spaceship_x < 0)
+        world->spaceship_x = 0;
+    if (world->spaceship_x + world->config.spaceship_width > world->config.board_width)
+        world->spaceship_x = world->config.board_width - world->config.spaceship_width;
+    vGridUpdateSpaceship(world);
+}
+
+int world_spaceship_bullet_active(const world_t *world)
+{
+    return world->bullets.count_by_type[SPACESHIP_BULLET] > 0;
+}
+
+static void vUpdateBulletPosition(world_t *world)
+{
+    bullet_pool_t *bullets = &world->bullets;
+    int k;
+
+    BULLET_POOL_FOREACH(bullets, k) {
+        bullets->prev_y[k] = bullets->y[k];
+        bullets->y[k] += bullet_velocity[bullets->type[k]];
+    }
+}
+
+/**
+ * @brief Puts every monster back at its starting place, alive. The
+ * rows keep the proportions of the original wave: small monsters on
+ * top, then medium and large ones.
+ *
+ */
+static void vResetFormation(formation_t *f, const world_config_t *config,
+                            const wave_t *wave, int monster_delay_ms)
+{
+    int i, j;
+
+    memset(f, 0, sizeof(*f));
+    f->n_rows = wave->formation_rows;
+    if (f->n_rows < 1)
+        f->n_rows = 1;
+    if (f->n_rows > FORMATION_MAX_ROWS)
+        f->n_rows = FORMATION_MAX_ROWS;
+    f->n_columns = wave->formation_columns;
+    if (f->n_columns < 1)
+        f->n_columns = 1;
+    if (f->n_columns > FORMATION_MAX_COLUMNS)
+        f->n_columns = FORMATION_MAX_COLUMNS;
+
+    for (i = 0; i < f->n_rows; i++) {
+        f->type[i] = wave->row_type[i] < N_MONSTER_TYPES ?
+                     wave->row_type[i] : SMALL_MONSTER;
+        f->width[i] = config->monster_width[f->type[i]];
+        f->height[i] = config->monster_height[f->type[i]];
+
+        f->origin_x[i] = MONSTER_ORIGIN_X;
+        f->origin_y[i] = MONSTER_ORIGIN_Y(config->board_height)
+                         + MONSTER_SPACING_V * i;
+        vBitsetFill(f->row_alive[i], f->n_columns);
+        f->row_count[i] = f->n_columns;
+    }
+    for (j = 0; j < f->n_columns; j++) {
+        vBitsetFill(f->column_alive[j], f->n_rows);
+        f->column_bottom[j] = f->n_rows - 1;
+        f->live_columns[j] = j;
+        f->live_column_index[j] = j;
+    }
+    f->n_live_columns = f->n_columns;
+    vBitsetFill(f->rows_alive, f->n_rows);
+    f->n_alive = f->n_rows * f->n_columns;
+    f->lowest_alive_row = f->n_rows - 1;
+
+    f->direction = LEFT_TO_RIGHT;
+    f->march_row = f->n_rows - 1;
+    f->march_column = 0;
+    f->march_wait_ms = 0;
+    f->monster_delay_ms = monster_delay_ms;
+}
+
+static int iFloorDiv(int a, int b)
+{
+    return a >= 0 ? a / b : -((-a + b - 1) / b);
+}
+
+/**
+ * @brief Maps a y coordinate to the only row of the lattice
+ * that could contain it.
+ *
+ * @return Row index, which is out of the range of rows if y is outside the lattice.
+ */
+static int iFindMonsterRow(const formation_t *f, int y)
+{
+    //rows are never taller than the spacing so at most one row can hold y
+    return iFloorDiv(y - f->origin_y[0], MONSTER_SPACING_V);
+}
+
+/**
+ * @brief Maps an x coordinate to the only column of a row
+ * that could contain it, taking the row's current step into account.
+ *
+ * @return Column index, or -1 if x is outside the lattice.
+ */
+static int iFindMonsterInRow(const formation_t *f, int i, int x)
+{
+    int j;
+
+    //columns before step_column are already displaced by the current step
+    j = iFloorDiv(x - f->origin_x[i], MONSTER_SPACING_H);
+    if (j < f->step_column[i]) {
+        j = iFloorDiv(x - f->origin_x[i] - f->step_change[i], MONSTER_SPACING_H);
+        if (j >= f->step_column[i])
+            return -1;
+    }
+    if (j < 0 || j >= f->n_columns)
+        return -1;
+
+    return j;
+}
+
+int world_monster_x(const formation_t *f, int i, int j)
+{
+    if (j < f->step_column[i])
+        return f->origin_x[i] + MONSTER_SPACING_H * j + f->step_change[i];
+
+    return f->origin_x[i] + MONSTER_SPACING_H * j;
+}
+
+int world_monster_alive(const formation_t *f, int i, int j)
+{
+    return iBitTest(f->row_alive[i], j);
+}
+
+int world_monster_frame(const formation_t *f, int i, int j)
+{
+    return (f->steps[i] + (j < f->step_column[i])) & 1;
+}
+
+/**
+ * @brief Folds the step that every monster of the row
+ * has just taken into the row origin.
+ *
+ */
+static void vFinishMonsterRowStep(formation_t *f, int i)
+{
+    f->origin_x[i] = f->origin_x[i] + f->step_change[i];
+    f->step_column[i] = 0;
+    f->step_change[i] = 0;
+    f->steps[i]++;
+}
+
+/**
+ * @brief If any monster touches the walls reverts direction
+ * and moves the whole formation down a step.
+ *
+ */
+static void vUpdateFormationDirection(formation_t *f, int board_width)
+{
+    int i, left, right, n_words = FORMATION_WORDS(f->n_columns);
+
+    for (i = 0; i < f->n_rows; i++) {
+        if (!f->row_count[i])
+            continue;
+        left = iBitsetFirst(f->row_alive[i], n_words);
+        right = iBitsetLast(f->row_alive[i], n_words);
+        if (world_monster_x(f, i, left) < WALL_MARGIN
+                || world_monster_x(f, i, right) + f->width[i]
+                   > board_width - WALL_MARGIN) {
+            f->direction = -1 * f->direction;
+            for (i = 0; i < f->n_rows; i++)
+                f->origin_y[i] = f->origin_y[i] + MONSTER_STEP_DOWN;
+            return;
+        }
+    }
+}
+
+/**
+ * @brief Ends the step of the row the march is on, the rows go
+ * bottom to top and at the end of the formation the walls are checked.
+ *
+ */
+static void vMarchNextRow(world_t *world)
+{
+    formation_t *f = &world->formation;
+
+    vFinishMonsterRowStep(f, f->march_row);
+    world->cues |= WORLD_CUE_MARCH;
+
+    f->march_column = 0;
+    f->march_row--;
+    if (f->march_row < 0) {
+        f->march_row = f->n_rows - 1;
+        vUpdateFormationDirection(f, world->config.board_width);
+    }
+}
+
+/**
+ * @brief Works out from the tempo how many alive monsters step in this
+ * tick and moves the march cursor past them in one pass. Dead monsters
+ * are skipped through the alive masks, a row is only visited once
+ * however many of its monsters step.
+ *
+ */
+static void vMarchFormation(world_t *world)
+{
+    formation_t *f = &world->formation;
+    int i, j, n_moves;
+
+    //an empty formation would never find a monster to wait on
+    if (!f->n_alive)
+        return;
+
+    f->march_wait_ms -= WORLD_TICK_MS;
+    if (f->march_wait_ms > 0)
+        return;
+
+    n_moves = 1 + -f->march_wait_ms / f->monster_delay_ms;
+    f->march_wait_ms += n_moves * f->monster_delay_ms;
+
+    while (n_moves) {
+        i = f->march_row;
+        f->step_change[i] = MONSTER_CHANGE * f->direction;
+
+        //counts off the alive monsters the cursor has not reached yet
+        j = iBitsetSelect(f->row_alive[i], FORMATION_WORDS(f->n_columns),
+                          f->march_column, &n_moves);
+        if (j < 0) {
+            vMarchNextRow(world);
+            continue;
+        }
+
+        f->march_column = j + 1;
+        f->step_column[i] = f->march_column;
+        if (f->march_column == f->n_columns)
+            vMarchNextRow(world);
+    }
+}
+
+static void vDecreaseMonsterDelay(formation_t *f, int n)
+{
+    f->monster_delay_ms = f->monster_delay_ms - n;
+    if (f->monster_delay_ms < 1)
+        f->monster_delay_ms = 1;
+}
+
+static void vSwapLiveColumns(formation_t *f, int a, int b)
+{
+    int j = f->live_columns[a];
+
+    f->live_columns[a] = f->live_columns[b];
+    f->live_columns[b] = j;
+    f->live_column_index[f->live_columns[a]] = a;
+    f->live_column_index[f->live_columns[b]] = b;
+}
+
+/**
+ * @brief Keeps the bottom of column j up to date once monster (i, j) is
+ * gone, and takes the column out of the live set when it empties.
+ *
+ */
+static void vUpdateColumn(formation_t *f, int i, int j)
+{
+    if (i != f->column_bottom[j])
+        return;
+
+    f->column_bottom[j] = iBitsetLast(f->column_alive[j], FORMATION_WORDS(f->n_rows));
+    if (f->column_bottom[j] >= 0)
+        return;
+
+    vSwapLiveColumns(f, f->live_column_index[j], f->n_live_columns - 1);
+    f->n_live_columns--;
+    f->live_column_index[j] = -1;
+}
+
+/**
+ * @brief Kills every monster killed in the tick and
+ * speeds up the formation once for all of them.
+ *
+ */
+static void vKillMonsters(formation_t *f, const game_events_t *events)
+{
+    int i, j, w, n, n_killed = 0;
+    uint64_t killed;
+
+    for (i = 0; i < f->n_rows; i++) {
+        for (w = 0; w < FORMATION_WORDS(f->n_columns); w++) {
+            killed = events->monsters_killed[i][w] & f->row_alive[i][w];
+            if (!killed)
+                continue;
+
+            n = __builtin_popcountll(killed);
+            n_killed += n;
+            f->row_count[i] -= n;
+            f->row_alive[i][w] &= ~killed;
+
+            while (killed) {
+                j = w * 64 + __builtin_ctzll(killed);
+                killed &= killed - 1;
+                vBitClear(f->column_alive[j], i);
+                vUpdateColumn(f, i, j);
+            }
+        }
+        if (!f->row_count[i])
+            vBitClear(f->rows_alive, i);
+    }
+    if (!n_killed)
+        return;
+
+    f->n_alive -= n_killed;
+    f->lowest_alive_row = iBitsetLast(f->rows_alive, FORMATION_WORDS(f->n_rows));
+
+    vDecreaseMonsterDelay(f, n_killed);
+}
+
+/**
+ * @brief Gives the column whose slot of the bottom-most row
+ * lies under the spaceship's cannon.
+ *
+ * @return Column index, or -1 if the cannon is outside the formation.
+ */
+static int iColumnAboveSpaceship(const world_t *world)
+{
+    return iFindMonsterInRow(&world->formation, world->formation.lowest_alive_row,
+                             world->spaceship_x + world->config.spaceship_width / 2);
+}
+
+/**
+ * @brief Every volley the shooting columns are drawn without
+ * replacement from the set of live columns, so the cost only
+ * depends on the number of shooters and never on how many
+ * columns are dead. The mothership also shoots when driven by
+ * an opponent.
+ *
+ */
+static void vShootEnemyBullets(world_t *world)
+{
+    formation_t *f = &world->formation;
+    int i, j, s = 0, n_shooters;
+
+    world->shoot_wait_ms -= WORLD_TICK_MS;
+    if (world->shoot_wait_ms > 0)
+        return;
+    world->shoot_wait_ms += world->fire.period_ms;
+
+    n_shooters = world->fire.n_shooters;
+    if (n_shooters > f->n_live_columns)
+        n_shooters = f->n_live_columns;
+
+    if (n_shooters && world->fire.aimed) {
+        j = iColumnAboveSpaceship(world);
+        if (j >= 0 && f->live_column_index[j] >= 0)
+            vSwapLiveColumns(f, s++, f->live_column_index[j]);
+    }
+    //the shooters are gathered at the front of the set
+    for (; s < n_shooters; s++)
+        vSwapLiveColumns(f, s, s + uRngBelow(&world->shooter_rng,
+                                             f->n_live_columns - s));
+
+    for (s = 0; s < n_shooters; s++) {
+        j = f->live_columns[s];
+        i = f->column_bottom[j];
+        vBulletPoolSpawn(&world->bullets, world_monster_x(f, i, j) + f->width[i] / 2,
+                         f->origin_y[i] + f->height[i], MONSTER_BULLET);
+    }
+
+    if (world->n_players == 2)
+        vBulletPoolSpawn(&world->bullets,
+                         world->mothership_x + world->config.mothership_width / 2,
+                         world->mothership_y + world->config.mothership_height,
+                         MOTHERSHIP_BULLET);
+}
+
+/**
+ * @brief Revives the mothership at the edge it is about to fly from,
+ * reversing its direction, and restarts its spawn clock.
+ *
+ */
+static void vResetMothership(world_t *world)
+{
+    world->mothership_direction = -1 * world->mothership_direction;
+    if (world->mothership_direction == LEFT_TO_RIGHT)
+        world->mothership_x = 0;
+    if (world->mothership_direction == RIGHT_TO_LEFT)
+        world->mothership_x = world->config.board_width - world->config.mothership_width - 1;
+    if (world->mothership_direction == STOP)
+        world->mothership_direction = LEFT_TO_RIGHT;
+    world->mothership_alive = 1;
+    vGridUpdateMothership(world);
+
+    world->mothership_spawn_ms = 0;
+}
+
+static void vSetUpMothershipPVP(world_t *world)
+{
+    world->mothership_x = world->config.board_width * 2 / 3
+                          - world->config.mothership_width / 2;
+    world->mothership_alive = 1;
+    vGridUpdateMothership(world);
+}
+
+static int iIsMothershipInBoundsLeft(const world_t *world)
+{
+    return world->mothership_x > 0;
+}
+
+static int iIsMothershipInBoundsRight(const world_t *world)
+{
+    return world->mothership_x + world->config.mothership_width < world->config.board_width;
+}
+
+/**
+ * @brief Flies the mothership across the screen, it is reset
+ * and killed once it leaves.
+ *
+ */
+static void vUpdateMothershipPosition(world_t *world)
+{
+    if (!world->mothership_alive)
+        return;
+
+    world->mothership_x = world->mothership_x + world->mothership_direction;
+    vGridUpdateMothership(world);
+    if (!iIsMothershipInBoundsLeft(world) || !iIsMothershipInBoundsRight(world)) {
+        vResetMothership(world);
+        world->mothership_alive = 0;
+    }
+}
+
+/**
+ * @brief Moves the mothership as ordered by the opponent,
+ * without leaving the screen.
+ *
+ */
+static void vUpdateMothershipPositionPVP(world_t *world)
+{
+    if (!world->mothership_alive)
+        return;
+
+    if (world->mothership_direction == LEFT_TO_RIGHT && iIsMothershipInBoundsRight(world))
+        world->mothership_x = world->mothership_x + CHANGE_IN_POSITION_PVP;
+    if (world->mothership_direction == RIGHT_TO_LEFT && iIsMothershipInBoundsLeft(world))
+        world->mothership_x = world->mothership_x - CHANGE_IN_POSITION_PVP;
+    vGridUpdateMothership(world);
+}
+
+/**
+ * @brief Revives the mothership every mothership_period_ms of the
+ * wave since it was last reset.
+ *
+ */
+static void vUpdateMothershipSpawn(world_t *world)
+{
+    int period_ms = world->wave->mothership_period_ms;
+
+    world->mothership_spawn_ms += WORLD_TICK_MS;
+    if (world->mothership_spawn_ms < period_ms)
+        return;
+
+    world->mothership_spawn_ms -= period_ms;
+    world->mothership_alive = 1;
+    world->cues |= WORLD_CUE_MOTHERSHIP;
+}
+
+/**
+ * @brief Sweeps the bullet's y over the movement of the last tick,
+ * from prev_y to y, against the range of y values [lo, hi] for which
+ * the bullet counts as touching an object.
+ *
+ * @return Distance travelled before entering the range, or -1 if it was never entered.
+ */
+static int iSweepBullet(const bullet_pool_t *bullets, int k, int lo, int hi)
+{
+    int prev_y = bullets->prev_y[k], y = bullets->y[k];
+
+    if (y <= prev_y) {//going up
+        if (y > hi || prev_y < lo)
+            return -1;
+        return prev_y > hi ? prev_y - hi : 0;
+    }
+
+    if (y < lo || prev_y > hi)
+        return -1;
+    return prev_y < lo ? lo - prev_y : 0;
+}
+
+static int iBulletInColumn(const bullet_pool_t *bullets, int k, int x, int width)
+{
+    return bullets->x[k] >= x && bullets->x[k] <= x + width;
+}
+
+static int iSweepBulletHitCeiling(const bullet_pool_t *bullets, int k)
+{
+    //bullet exceeded top limit
+    if (bullets->type[k] != SPACESHIP_BULLET)
+        return -1;
+
+    return iSweepBullet(bullets, k, INT16_MIN, TOP_LINE_Y);
+}
+
+static int iSweepBulletHitFloor(const world_t *world, int k)
+{
+    const bullet_pool_t *bullets = &world->bullets;
+
+    if (bullets->type[k] != MONSTER_BULLET && bullets->type[k] != MOTHERSHIP_BULLET)
+        return -1;
+
+    return iSweepBullet(bullets, k, GREEN_LINE_Y(world->config.board_height)
+                        - BULLET_HEIGHT, INT16_MAX);
+}
+
+static int iSweepBulletHitMonster(const world_t *world, int k, int i, int j)
+{
+    const bullet_pool_t *bullets = &world->bullets;
+    const formation_t *f = &world->formation;
+
+    if (!iBitTest(f->row_alive[i], j) || bullets->type[k] != SPACESHIP_BULLET
+                || !iBulletInColumn(bullets, k, world_monster_x(f, i, j),
+                                    f->width[i]))
+        return -1;
+
+    return iSweepBullet(bullets, k, f->origin_y[i] + BULLET_HEIGHT,
+                        f->origin_y[i] + f->height[i]);
+}
+
+static int iSweepBulletHitSpaceship(const world_t *world, int k)
+{
+    const bullet_pool_t *bullets = &world->bullets;
+
+    if ((bullets->type[k] != MONSTER_BULLET && bullets->type[k] != MOTHERSHIP_BULLET)
+                || !iBulletInColumn(bullets, k, world->spaceship_x,
+                                    world->config.spaceship_width))
+        return -1;
+
+    return iSweepBullet(bullets, k, world->spaceship_y - BULLET_HEIGHT,
+                        world->spaceship_y + world->config.spaceship_height);
+}
+
+static int iSweepBulletHitMothership(const world_t *world, int k)
+{
+    const bullet_pool_t *bullets = &world->bullets;
+
+    if (!world->mothership_alive || bullets->type[k] != SPACESHIP_BULLET
+                || !iBulletInColumn(bullets, k, world->mothership_x,
+                                    world->config.mothership_width))
+        return -1;
+
+    return iSweepBullet(bullets, k, world->mothership_y + BULLET_HEIGHT,
+                        world->mothership_y + world->config.mothership_height);
+}
+
+static int iSweepBulletHitBunker(const world_t *world, int k, int a)
+{
+    const bullet_pool_t *bullets = &world->bullets;
+
+    //only the cells in the bullet's column are tested
+    return vBunkerBitmapSweep(&world->bunker[a], bullets->x[k] - world->bunker_x[a],
+                              bullets->prev_y[k] - world->bunker_y[a],
+                              bullets->y[k] - world->bunker_y[a], BULLET_HEIGHT);
+}
+
+/**
+ * @brief Runs the swept narrowphase test of a bullet against
+ * the object registered in the colision grid with the given id.
+ *
+ * @return Distance travelled before the hit, or -1 if missed
+ */
+static int iSweepBulletHitObject(const world_t *world, int k, int id)
+{
+    if (id == GRID_SPACESHIP)
+        return iSweepBulletHitSpaceship(world, k);
+    if (id == GRID_MOTHERSHIP)
+        return iSweepBulletHitMothership(world, k);
+
+    return iSweepBulletHitBunker(world, k, id - GRID_BUNKER(0));
+}
+
+static void vRecordHit(bullet_hit_t *hit, int distance, int kind, int i, int j)
+{
+    if (distance < 0)
+        return;
+    if (hit->kind != HIT_NONE && distance >= hit->distance)
+        return;
+
+    hit->distance = distance;
+    hit->kind = kind;
+    hit->i = i;
+    hit->j = j;
+}
+
+/**
+ * @brief Walks the rows of the monster lattice crossed by the bullet,
+ * in the order the bullet crossed them, and tests the only monster of
+ * each row the bullet could be over.
+ *
+ */
+static void vSweepBulletLattice(const world_t *world, int k, bullet_hit_t *hit,
+                                unsigned long *n_tests)
+{
+    const bullet_pool_t *bullets = &world->bullets;
+    const formation_t *f = &world->formation;
+    int i, j, first_row, last_row;
+
+    //only spaceship bullets hit monsters and they only go up
+    if (bullets->type[k] != SPACESHIP_BULLET)
+        return;
+
+    first_row = iFindMonsterRow(f, bullets->prev_y[k] - BULLET_HEIGHT);
+    last_row = iFindMonsterRow(f, bullets->y[k] - BULLET_HEIGHT);
+    if (first_row >= f->n_rows)
+        first_row = f->n_rows - 1;
+    if (last_row < 0)
+        last_row = 0;
+
+    for (i = first_row; i >= last_row; i--) {
+        j = iFindMonsterInRow(f, i, bullets->x[k]);
+        //monsters killed earlier in the tick are only removed when events are applied
+        if (j < 0 || iBitTest(world->events.monsters_killed[i], j))
+            continue;
+        (*n_tests)++;
+        vRecordHit(hit, iSweepBulletHitMonster(world, k, i, j), HIT_MONSTER, i, j);
+        if (hit->kind == HIT_MONSTER)
+            return;
+    }
+}
+
+/**
+ * @brief Checks if the object was already hit earlier in the tick.
+ *
+ */
+static int iObjectAlreadyHit(const game_events_t *events, int id)
+{
+    if (id == GRID_SPACESHIP)
+        return events->spaceship_hit;
+    if (id == GRID_MOTHERSHIP)
+        return events->mothership_hit;
+    return 0;
+}
+
+static void vRecordBulletHitMonster(const world_t *world, int i, int j,
+                                    game_event_t *event)
+{
+    const formation_t *f = &world->formation;
+
+    event->type = EVENT_MONSTER_KILLED;
+    event->x = world_monster_x(f, i, j) + f->width[i] / 2;
+    event->y = f->origin_y[i] + f->height[i] / 2;
+    event->i = i;
+    event->j = j;
+}
+
+static void vRecordBulletHitObject(const world_t *world, int k, int id,
+                                   int hit_y, game_event_t *event)
+{
+    const bullet_pool_t *bullets = &world->bullets;
+
+    if (id == GRID_SPACESHIP) {
+        event->type = EVENT_PLAYER_HIT;
+        event->x = world->spaceship_x + world->config.spaceship_width / 2;
+        event->y = world->spaceship_y + world->config.spaceship_height / 2;
+        return;
+    }
+
+    if (id == GRID_MOTHERSHIP) {
+        event->type = EVENT_MOTHERSHIP_HIT;
+        event->x = world->mothership_x + world->config.mothership_width / 2;
+        event->y = world->mothership_y + world->config.mothership_height / 2;
+        return;
+    }
+
+    //the blast is centered on the leading end of the bullet
+    event->type = EVENT_BUNKER_HIT;
+    event->i = id - GRID_BUNKER(0);
+    event->x = bullets->x[k];
+    if (bullets->y[k] <= bullets->prev_y[k])
+        event->y = hit_y;
+    else
+        event->y = hit_y + BULLET_HEIGHT - 1;
+}
+
+/**
+ * @brief Finds the hits of every bullet over the last move and appends
+ * them as events. Objects are left untouched until the events are applied.
+ *
+ */
+static void vCheckBulletColision(world_t *world)
+{
+    int k, w, id, hit_y, path_top, path_bottom;
+    unsigned long n_tests = 0;
+    uint64_t candidates[BROADPHASE_WORDS], bits;
+    bullet_pool_t *bullets = &world->bullets;
+    bullet_hit_t hit;
+    game_event_t event;
+
+    BULLET_POOL_FOREACH(bullets, k) {
+        hit.kind = HIT_NONE;
+
+        vSweepBulletLattice(world, k, &hit, &n_tests);
+
+        if (bullets->y[k] <= bullets->prev_y[k]) {
+            path_top = bullets->y[k];
+            path_bottom = bullets->prev_y[k];
+        } else {
+            path_top = bullets->prev_y[k];
+            path_bottom = bullets->y[k];
+        }
+
+        //only objects sharing a grid cell with the bullet's path are tested
+        vBroadphaseQuery(&world->grid, bullets->x[k],
+                         path_top - BULLET_HEIGHT, bullets->x[k] + BULLET_WIDTH,
+                         path_bottom + BULLET_HEIGHT, candidates);
+
+        for (w = 0; w < BROADPHASE_WORDS; w++) {
+            bits = candidates[w];
+            while (bits) {
+                id = w * 64 + __builtin_ctzll(bits);
+                bits &= bits - 1;
+                if (iObjectAlreadyHit(&world->events, id))
+                    continue;
+                n_tests++;
+                vRecordHit(&hit, iSweepBulletHitObject(world, k, id),
+                           HIT_OBJECT, id, 0);
+            }
+        }
+
+        vRecordHit(&hit, iSweepBulletHitCeiling(bullets, k), HIT_CEILING, 0, 0);
+        vRecordHit(&hit, iSweepBulletHitFloor(world, k), HIT_FLOOR, 0, 0);
+
+        if (hit.kind == HIT_NONE)
+            continue;
+
+        //y of the bullet at the moment of the hit
+        if (bullets->y[k] <= bullets->prev_y[k])
+            hit_y = bullets->prev_y[k] - hit.distance;
+        else
+            hit_y = bullets->prev_y[k] + hit.distance;
+
+        event.type = EVENT_BULLET_SPENT;
+        event.x = bullets->x[k];
+        event.y = hit_y;
+        event.i = 0;
+        event.j = 0;
+        event.bullet_type = bullets->type[k];
+
+        switch (hit.kind) {
+            case HIT_FLOOR:
+                event.y = hit_y + BULLET_HEIGHT;
+                break;
+            case HIT_MONSTER:
+                vRecordBulletHitMonster(world, hit.i, hit.j, &event);
+                break;
+            case HIT_OBJECT:
+                vRecordBulletHitObject(world, k, hit.i, hit_y, &event);
+                break;
+            default:
+                break;
+        }
+
+        vPushGameEvent(&world->events, &event);
+
+        //the bullet gets killed, its slot is released in place
+        vBulletPoolRemoveAt(bullets, k);
+    }
+    world->grid.narrowphase_tests += n_tests;
+    vBroadphaseEndTick(&world->grid);
+}
+
+/**
+ * @brief Applies the events found in the tick and keeps what fits of
+ * them to be shown.
+ *
+ */
+static void vApplyGameEvents(world_t *world)
+{
+    const game_events_t *events = &world->events;
+    const game_event_t *event;
+    uint32_t bunkers_hit = 0;
+    int k, a;
+
+    if (!events->count)
+        return;
+
+    for (k = 0; k < events->count; k++) {
+        event = &events->event[k];
+        if (world->n_shown < MAX_SHOWN_EVENTS)
+            world->shown[world->n_shown++] = *event;
+        switch (event->type) {
+            case EVENT_MONSTER_KILLED:
+                world->score1 += monster_score[world->formation.type[event->i]];
+                world->cues |= WORLD_CUE_MONSTER_KILLED;
+                break;
+            case EVENT_MOTHERSHIP_HIT:
+                world->score1 += 50 * (uRngBelow(&world->mothership_rng, 4) + 1);
+                break;
+            case EVENT_PLAYER_HIT:
+                world->n_lives--;
+                //mothership kills count for player 2
+                if (event->bullet_type == MOTHERSHIP_BULLET)
+                    world->score2 += 1000;
+                world->cues |= WORLD_CUE_EXPLOSION;
+                break;
+            case EVENT_BUNKER_HIT:
+                vBunkerBitmapErode(&world->bunker[event->i],
+                                   event->x - world->bunker_x[event->i],
+                                   event->y - world->bunker_y[event->i]);
+                bunkers_hit |= 1u << event->i;
+                break;
+            default:
+                break;
+        }
+    }
+
+    vKillMonsters(&world->formation, events);
+
+    for (a = 0; a < N_BUNKERS; a++)
+        if ((bunkers_hit & (1u << a)) && vBunkerBitmapEmpty(&world->bunker[a]))
+            vBroadphaseRemove(&world->grid, GRID_BUNKER(a));
+
+    if (events->spaceship_hit)
+        vResetSpaceship(world);
+
+    if (events->mothership_hit && world->n_players == 1) {
+        vResetMothership(world);
+        world->mothership_alive = 0;
+    }
+}
+
+static void vUpdateStatus(world_t *world)
+{
+    const formation_t *f = &world->formation;
+    int i = f->lowest_alive_row;
+
+    //every monster of a row sits at the row's y
+    if (world->n_lives <= 0
+            || (i >= 0 && f->origin_y[i] + f->height[i] >= world->bunker_y[1]))
+        world->status = WORLD_PLAYER_DEAD;
+    else if (!f->n_alive)
+        world->status = WORLD_WAVE_CLEARED;
+}
+
+static void vWorldTick(world_t *world, const input_t *input)
+{
+    vUpdateBulletPosition(world);
+    if (world->n_players == 1) {
+        vUpdateMothershipPosition(world);
+    } else {
+        world->mothership_direction = input->mothership_direction;
+        vUpdateMothershipPositionPVP(world);
+    }
+
+    world->events.count = 0;
+    vClearTickHits(&world->events);
+    vCheckBulletColision(world);
+    vApplyGameEvents(world);
+
+    if (input->shoot && !world_spaceship_bullet_active(world)) {
+        vBulletPoolSpawn(&world->bullets,
+                         world->spaceship_x + world->config.spaceship_width / 2,
+                         world->spaceship_y, SPACESHIP_BULLET);
+        world->cues |= WORLD_CUE_SHOOT;
+    }
+    vMoveSpaceship(world, input->move);
+
+    vMarchFormation(world);
+    vShootEnemyBullets(world);
+    if (world->n_players == 1)
+        vUpdateMothershipSpawn(world);
+
+    world->tick++;
+    vUpdateStatus(world);
+}
+
+void world_set_fire_pattern(world_t *world, const fire_pattern_t *fire)
+{
+    world->fire = *fire;
+    if (world->fire.period_ms < WORLD_TICK_MS)
+        world->fire.period_ms = WORLD_TICK_MS;
+    if (world->fire.n_shooters < 0)
+        world->fire.n_shooters = 0;
+}
+
+void world_step(world_t *world, const input_t *input, uint32_t dt_ms)
+{
+    world->n_shown = 0;
+    world->cues = 0;
+
+    world->leftover_ms += dt_ms;
+    while (world->leftover_ms >= WORLD_TICK_MS && world->status == WORLD_PLAYING) {
+        world->leftover_ms -= WORLD_TICK_MS;
+        vWorldTick(world, input);
+    }
+}
+
+void world_original_wave(wave_t *wave, int n_rows, int n_columns)
+{
+    int i, j;
+
+    memset(wave, 0, sizeof(*wave));
+    wave->formation_rows = n_rows;
+    wave->formation_columns = n_columns;
+    wave->monster_delay_ms = ORIGINAL_MONSTER_DELAY;
+    wave->n_shooters = 1;
+    wave->fire_period_ms = MONSTER_SHOOT_PERIOD;
+    wave->mothership_period_ms = ORIGINAL_TIMER;
+    wave->aimed = 0;
+
+    for (i = 0; i < n_rows && i < FORMATION_MAX_ROWS; i++) {
+        j = i * N_ROWS / n_rows;
+        if (j == 0)
+            wave->row_type[i] = SMALL_MONSTER;
+        else if (j <= 2)
+            wave->row_type[i] = MEDIUM_MONSTER;
+        else
+            wave->row_type[i] = LARGE_MONSTER;
+    }
+
+    //evenly spread over the board
+    for (i = 0; i < N_BUNKERS; i++)
+        wave->bunker_x_permille[i] = 1000 * i / N_BUNKERS;
+}
+
+void world_reset_board(world_t *world, const wave_t *wave,
+                       int monster_delay_offset_ms)
+{
+    const fire_pattern_t fire = { wave->fire_period_ms, wave->n_shooters,
+                                  wave->aimed };
+    int k;
+
+    world->wave = wave;
+
+    vBulletPoolInit(&world->bullets);
+    vResetFormation(&world->formation, &world->config, wave,
+                    wave->monster_delay_ms + monster_delay_offset_ms);
+    world_set_fire_pattern(world, &fire);
+    world->shoot_wait_ms = 0;
+
+    vResetSpaceship(world);
+
+    for (k = 0; k < N_BUNKERS; k++) {
+        world->bunker_y[k] = BUNKER_Y(world->config.board_height);
+        if (wave->bunker_x_permille[k] == WAVE_NO_BUNKER) {
+            //stays empty for the whole wave, as if it had been shot away
+            world->bunker_x[k] = BUNKER_MARGIN_X;
+            memset(&world->bunker[k], 0, sizeof(world->bunker[k]));
+            vBroadphaseRemove(&world->grid, GRID_BUNKER(k));
+            continue;
+        }
+        world->bunker_x[k] = world->config.board_width
+                             * wave->bunker_x_permille[k] / 1000 + BUNKER_MARGIN_X;
+        vBunkerBitmapInit(&world->bunker[k]);
+        vBroadphaseUpdate(&world->grid, GRID_BUNKER(k), world->bunker_x[k],
+                          world->bunker_y[k], BUNKER_WIDTH, BUNKER_HEIGHT);
+    }
+
+    if (world->n_players == 1) {
+        vResetMothership(world);
+        world->mothership_alive = 0;
+    } else {
+        vSetUpMothershipPVP(world);
+    }
+
+    world->events.count = 0;
+    vClearTickHits(&world->events);
+    world->n_shown = 0;
+    world->cues = 0;
+    world->leftover_ms = 0;
+    world->status = WORLD_PLAYING;
+}
+
+void world_start_match(world_t *world, int n_players, int n_lives, int score,
+                       const wave_t *wave, int monster_delay_offset_ms)
+{
+    world->n_players = n_players;
+    world->score1 = score;
+    world->score2 = 0;
+    world->n_lives = n_lives;
+
+    //the board reset turns it around so the first flyby goes left to right
+    world->mothership_direction = RIGHT_TO_LEFT;
+
+    world_reset_board(world, wave, monster_delay_offset_ms);
+}
+
+void world_init(world_t *world, const world_config_t *config,
+                const wave_t *wave, uint32_t seed)
+{
+    memset(world, 0, sizeof(*world));
+    world->config = *config;
+    vRngSeed(&world->shooter_rng, seed, WORLD_RNG_SHOOTER);
+    vRngSeed(&world->mothership_rng, seed, WORLD_RNG_MOTHERSHIP);
+
+    vBroadphaseInit(&world->grid, world->config.board_width,
+                    world->config.board_height);
+
+    world->mothership_x = 0;
+    world->mothership_y = MOTHERSHIP_Y;
+
+    world_start_match(world, 1, INITIAL_LIVES, 0, wave, 0);
+}